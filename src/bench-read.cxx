@@ -0,0 +1,127 @@
+/*
+ * bench-read.cxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ *
+ * Read a whole dataset with each storage backend and print the throughput.
+ * Pages of the file are dropped from the page cache before each run when
+ * possible, thus runs measure cold reads.
+ *
+ * A last run reads the whole file with io_uring in requests of at most
+ * 64 KiB, every run is then completed by short reads, and checks the bytes.
+ */
+
+#include <hdf5-ng.hxx>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+static void drop_page_cache(char const * filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return;
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+static void read_all(h5ng::h5obj & d, void * out, bool parallel)
+{
+	using h5ng::slc;
+	switch (d.shape().size()) {
+	case 1:
+		parallel ? d.read_parallel(out, slc{}) : d.read(out, slc{});
+		break;
+	case 2:
+		parallel ? d.read_parallel(out, slc{}, slc{}) : d.read(out, slc{}, slc{});
+		break;
+	case 3:
+		parallel ? d.read_parallel(out, slc{}, slc{}, slc{}) : d.read(out, slc{}, slc{}, slc{});
+		break;
+	case 4:
+		parallel ? d.read_parallel(out, slc{}, slc{}, slc{}, slc{}) : d.read(out, slc{}, slc{}, slc{}, slc{});
+		break;
+	default:
+		throw runtime_error("Unsupported dataset rank");
+	}
+}
+
+int main(int argc, char const ** argv) {
+	if (argc < 3) {
+		cerr << "usage: " << argv[0] << " <file> <dataset> [repeat]" << endl;
+		return 1;
+	}
+
+	int repeat = argc > 3 ? atoi(argv[3]) : 3;
+
+	pair<h5ng::storage_backend_e, char const *> const backends[] = {
+		{h5ng::STORAGE_MMAP, "mmap"},
+		{h5ng::STORAGE_PREAD, "pread"},
+		{h5ng::STORAGE_IO_URING, "io_uring"}
+	};
+
+	for (auto const & backend: backends) {
+		for (bool parallel: {false, true}) {
+			double best = 0.0;
+			uint64_t size = 0;
+			for (int r = 0; r < repeat; ++r) {
+				drop_page_cache(argv[1]);
+
+				auto t0 = chrono::steady_clock::now();
+				h5ng::h5obj f(argv[1], backend.first);
+				auto d = f[argv[2]];
+				d.set_chunk_cache_size(0);
+				size = d.element_size();
+				for (auto x: d.shape())
+					size *= x;
+				vector<uint8_t> out(size);
+				read_all(d, &out[0], parallel);
+				double t = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+				if (r == 0 or t < best)
+					best = t;
+			}
+
+			cout << backend.second << (parallel ? " parallel" : " serial  ")
+				 << " " << size/(1024.0*1024.0)/best << " MiB/s"
+				 << " (best of " << repeat << ", " << best << " s)" << endl;
+		}
+	}
+
+#ifdef HAVE_LINUX_IO_URING_H
+	{
+		drop_page_cache(argv[1]);
+
+		auto t0 = chrono::steady_clock::now();
+		h5ng::io_uring_storage s(argv[1]);
+		if (s.backend() != h5ng::STORAGE_IO_URING) {
+			cout << "io_uring short reads: io_uring not available" << endl;
+			return 0;
+		}
+		s.set_max_read_size(1ul<<16);
+		vector<h5ng::storage_extent_t> extents;
+		for (uint64_t offset = 0; offset < s.size(); offset += 1ul<<20)
+			extents.push_back(h5ng::storage_extent_t{offset, min<uint64_t>(1ul<<20, s.size()-offset)});
+		uint64_t mismatch = 0;
+		s.fetch(extents, false, [&](size_t i, uint8_t const * data) {
+			if (memcmp(data, s.data() + extents[i].offset, extents[i].size) != 0)
+				++mismatch;
+		});
+		double t = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+
+		cout << "io_uring short reads " << s.size()/(1024.0*1024.0)/t << " MiB/s"
+			 << " (" << t << " s, " << mismatch << " mismatching extents)" << endl;
+		if (mismatch > 0)
+			return 1;
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * bench-write.cxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ *
+ * Append frames of 1024x1024 uint16 to an unlimited dataset, without filter,
+ * with deflate and with shuffle+deflate, for each thread count, and print the
+ * append rate. Frames are a ramp with some noise, thus they compress about
+ * as well as detector images.
+ */
+
+#include <h5ng-writer.hxx>
+#include <h5ng-thread-pool.hxx>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+
+#include <sys/stat.h>
+
+using namespace std;
+
+int main(int argc, char const ** argv) {
+	if (argc < 2) {
+		cerr << "usage: " << argv[0] << " <file> [frames] [thread count ...]" << endl;
+		return 1;
+	}
+
+	int frames = argc > 2 ? atoi(argv[2]) : 256;
+	vector<unsigned> thread_counts;
+	for (int i = 3; i < argc; ++i)
+		thread_counts.push_back(atoi(argv[i]));
+	if (thread_counts.empty())
+		thread_counts = {1, 2, 4};
+
+	uint64_t const width = 1024;
+	vector<uint16_t> data(4*width*width);
+	mt19937 g{1};
+	for (uint64_t i = 0; i < data.size(); ++i)
+		data[i] = (i%width)*16 + g()%64;
+
+	struct mode_t {
+		char const * name;
+		bool shuffle;
+		int deflate_level;
+	};
+
+	mode_t const modes[] = {
+		{"none", false, -1},
+		{"deflate", false, 4},
+		{"shuffle+deflate", true, 4}
+	};
+
+	for (auto const & mode: modes) {
+		for (auto thread_count: thread_counts) {
+			h5ng::set_thread_count(thread_count);
+
+			auto t0 = chrono::steady_clock::now();
+			{
+				h5ng::h5writer w(argv[1]);
+				h5ng::dataset_options_t options;
+				options.unlimited = true;
+				options.chunk_shape = {1, width, width};
+				options.shuffle = mode.shuffle;
+				options.deflate_level = mode.deflate_level;
+				auto d = w.create_dataset<uint16_t>("frames", {0, width, width}, options);
+				for (int i = 0; i < frames; ++i)
+					d.append(&data[(i%4)*width*width], 1);
+				w.close();
+			}
+			double t = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+
+			struct stat st;
+			stat(argv[1], &st);
+			double size = frames*width*width*sizeof(uint16_t);
+			cout << mode.name << " threads=" << thread_count
+				 << " " << size/(1024.0*1024.0)/t << " MiB/s"
+				 << " (" << frames/t << " frames/s, ratio " << size/st.st_size << ")" << endl;
+		}
+	}
+
+	return 0;
+}
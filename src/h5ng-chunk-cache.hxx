@@ -0,0 +1,147 @@
+/*
+ * h5ng-chunk-cache.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_CHUNK_CACHE_HXX_
+#define SRC_H5NG_CHUNK_CACHE_HXX_
+
+#include <cstdint>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+#include "h5ng.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+/**
+ * Cache of decoded chunks, bounded by a byte budget and evicted in LRU order.
+ *
+ * Chunks are identified by the dataset object offset and the chunk
+ * coordinates. Data are shared, thus a chunk evicted while being used by a
+ * reader stay valid until the reader release it.
+ **/
+class chunk_cache {
+public:
+	using data_type = shared_ptr<vector<uint8_t> const>;
+
+private:
+	struct key_type {
+		uint64_t object;
+		vector<uint64_t> coords;
+
+		bool operator==(key_type const & x) const {
+			return object == x.object and coords == x.coords;
+		}
+	};
+
+	struct key_hash {
+		size_t operator()(key_type const & k) const {
+			uint64_t h = k.object*0x9e3779b97f4a7c15ul;
+			for (auto x: k.coords) {
+				h ^= x + 0x9e3779b97f4a7c15ul + (h << 6) + (h >> 2);
+			}
+			return h;
+		}
+	};
+
+	struct entry {
+		key_type key;
+		data_type data;
+	};
+
+	mutable mutex _lock;
+
+	// most recently used first.
+	list<entry> _lru;
+	unordered_map<key_type, typename list<entry>::iterator, key_hash> _index;
+
+	uint64_t _budget;
+	uint64_t _size;
+	uint64_t _hits;
+	uint64_t _misses;
+	uint64_t _evictions;
+
+	// must be called with lock held.
+	void _evict(uint64_t budget)
+	{
+		while (_size > budget and not _lru.empty()) {
+			auto & e = _lru.back();
+			_size -= e.data->size();
+			_index.erase(e.key);
+			_lru.pop_back();
+			++_evictions;
+		}
+	}
+
+public:
+
+	explicit chunk_cache(uint64_t budget) :
+		_budget{budget}, _size{0}, _hits{0}, _misses{0}, _evictions{0} { }
+
+	chunk_cache(chunk_cache const &) = delete;
+	chunk_cache & operator=(chunk_cache const &) = delete;
+
+	// return the chunk or null if not in the cache.
+	data_type find(uint64_t object, uint64_t const * coords, size_t rank)
+	{
+		key_type key{object, vector<uint64_t>{coords, coords+rank}};
+		unique_lock<mutex> l{_lock};
+		auto x = _index.find(key);
+		if (x == _index.end()) {
+			++_misses;
+			return nullptr;
+		}
+		++_hits;
+		_lru.splice(_lru.begin(), _lru, x->second);
+		return x->second->data;
+	}
+
+	// insert a chunk, chunk larger than the budget are not stored.
+	void insert(uint64_t object, uint64_t const * coords, size_t rank, data_type const & data)
+	{
+		key_type key{object, vector<uint64_t>{coords, coords+rank}};
+		unique_lock<mutex> l{_lock};
+		if (data->size() > _budget)
+			return;
+		if (_index.find(key) != _index.end())
+			return; // inserted by a concurrent reader.
+		_evict(_budget-data->size());
+		_lru.push_front(entry{key, data});
+		_index[key] = _lru.begin();
+		_size += data->size();
+	}
+
+	void set_budget(uint64_t budget)
+	{
+		unique_lock<mutex> l{_lock};
+		_budget = budget;
+		_evict(_budget);
+	}
+
+	void clear()
+	{
+		unique_lock<mutex> l{_lock};
+		_lru.clear();
+		_index.clear();
+		_size = 0;
+	}
+
+	chunk_cache_stats_t stats() const
+	{
+		unique_lock<mutex> l{_lock};
+		return chunk_cache_stats_t{_hits, _misses, _evictions, _size, _budget};
+	}
+
+};
+
+} // h5ng
+
+#endif /* SRC_H5NG_CHUNK_CACHE_HXX_ */
@@ -0,0 +1,265 @@
+/*
+ * h5ng-chunk-index.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_CHUNK_INDEX_HXX_
+#define SRC_H5NG_CHUNK_INDEX_HXX_
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <limits>
+#include <algorithm>
+
+#include "h5ng.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+// Allocated chunk of a flattened index, tables are sorted by linear index.
+struct chunk_entry_t {
+	uint64_t linear;   //< row-major position of the chunk in the grid
+	uint64_t address;
+	uint32_t size;
+	uint32_t filters;
+};
+
+/**
+ * Flat index of the chunks of a dataset, whatever the indexing type used in
+ * the file. The index cover the chunk grid of the current dataspace, chunks
+ * are addressed by their grid coordinates (i.e. offset/chunk_shape).
+ *
+ * The index is filled with insert() then finalize() choose the storage: a
+ * dense array over the grid when it is mostly allocated, a hash table
+ * otherwise. Once finalized the index is read-only and can be shared.
+ *
+ * An index can also be a view over a sorted table of chunk_entry_t, e.g.
+ * within a mapped sidecar index, chunks are then looked up by bisection.
+ **/
+class chunk_index {
+	vector<uint64_t> _chunk_shape; //< number of elements of a chunk per dimension
+	vector<uint64_t> _grid;        //< number of chunks per dimension
+	uint64_t _cells;               //< number of chunks in the grid
+	uint64_t _count;               //< number of allocated chunks
+
+	// only one of them is used after finalize.
+	vector<chunk_desc_t> _dense;
+	unordered_map<uint64_t, chunk_desc_t> _sparse;
+
+	// view mode, _owner keep the table alive.
+	chunk_entry_t const * _table;
+	shared_ptr<void const> _owner;
+
+	vector<pair<uint64_t, chunk_desc_t>> _pending;
+
+	static chunk_desc_t _not_allocated()
+	{
+		return chunk_desc_t{0u, 0u, numeric_limits<uint64_t>::max()};
+	}
+
+	chunk_desc_t _find_linear(uint64_t i) const
+	{
+		if (_table) {
+			auto x = std::lower_bound(_table, _table+_count, i, [](chunk_entry_t const & a, uint64_t i) { return a.linear < i; });
+			if (x == _table+_count or x->linear != i)
+				return _not_allocated();
+			return chunk_desc_t{x->size, x->filters, x->address};
+		}
+		if (not _dense.empty())
+			return _dense[i];
+		auto x = _sparse.find(i);
+		if (x == _sparse.end())
+			return _not_allocated();
+		return x->second;
+	}
+
+public:
+
+	// The dense array is used if less than 1/DENSE_RATIO of the grid is empty
+	// or if the grid is small anyway.
+	enum : uint64_t {
+		DENSE_RATIO = 4,
+		DENSE_MIN_CELLS = 1ul<<16
+	};
+
+	chunk_index(vector<uint64_t> const & chunk_shape, vector<uint64_t> const & grid) :
+		_chunk_shape{chunk_shape}, _grid{grid}, _cells{1}, _count{0}, _table{nullptr}
+	{
+		for (auto x: _grid)
+			_cells *= x;
+	}
+
+	// view over count entries sorted by linear index, the index is already finalized.
+	chunk_index(vector<uint64_t> const & chunk_shape, vector<uint64_t> const & grid,
+			chunk_entry_t const * table, uint64_t count, shared_ptr<void const> const & owner) :
+		_chunk_shape{chunk_shape}, _grid{grid}, _cells{1}, _count{count}, _table{table}, _owner{owner}
+	{
+		for (auto x: _grid)
+			_cells *= x;
+	}
+
+	chunk_index(chunk_index const &) = delete;
+	chunk_index & operator=(chunk_index const &) = delete;
+
+	size_t rank() const
+	{
+		return _grid.size();
+	}
+
+	vector<uint64_t> const & grid() const
+	{
+		return _grid;
+	}
+
+	vector<uint64_t> const & chunk_shape() const
+	{
+		return _chunk_shape;
+	}
+
+	// number of allocated chunks
+	uint64_t size() const
+	{
+		return _count;
+	}
+
+	// row-major position of the chunk in the grid, scaled must be within the grid.
+	uint64_t linear_index(uint64_t const * scaled) const
+	{
+		uint64_t ret = 0;
+		for (size_t i = 0; i < _grid.size(); ++i) {
+			ret = ret*_grid[i] + scaled[i];
+		}
+		return ret;
+	}
+
+	bool contains(uint64_t const * scaled) const
+	{
+		for (size_t i = 0; i < _grid.size(); ++i) {
+			if (scaled[i] >= _grid[i])
+				return false;
+		}
+		return true;
+	}
+
+	// add a chunk, chunks outside of the grid are ignored.
+	void insert(uint64_t const * scaled, chunk_desc_t const & chunk)
+	{
+		if (not contains(scaled))
+			return;
+		_pending.emplace_back(linear_index(scaled), chunk);
+	}
+
+	void finalize()
+	{
+		_count = _pending.size();
+		if (_cells <= std::max<uint64_t>(DENSE_MIN_CELLS, _count*DENSE_RATIO)) {
+			_dense.assign(_cells, _not_allocated());
+			for (auto const & x: _pending) {
+				_dense[x.first] = x.second;
+			}
+		} else {
+			_sparse.reserve(_count);
+			for (auto const & x: _pending) {
+				_sparse.emplace(x.first, x.second);
+			}
+		}
+		_pending.clear();
+		_pending.shrink_to_fit();
+	}
+
+	// return the chunk with the given grid coordinates, size_of_chunk is 0 if the chunk is not allocated.
+	chunk_desc_t find_scaled(uint64_t const * scaled) const
+	{
+		if (not contains(scaled))
+			return _not_allocated();
+		return _find_linear(linear_index(scaled));
+	}
+
+	// return the chunk that contains the element at offset.
+	chunk_desc_t find(uint64_t const * offset) const
+	{
+		uint64_t i = 0;
+		for (size_t d = 0; d < _grid.size(); ++d) {
+			uint64_t s = offset[d]/_chunk_shape[d];
+			if (s >= _grid[d])
+				return _not_allocated();
+			i = i*_grid[d] + s;
+		}
+		return _find_linear(i);
+	}
+
+	// call func(scaled, chunk) for each allocated chunk in grid order.
+	template<typename F>
+	void for_each(F && func) const
+	{
+		vector<uint64_t> scaled(_grid.size());
+		auto visit = [&](uint64_t i, chunk_desc_t const & chunk) {
+			for (size_t d = _grid.size(); d-- > 0;) {
+				scaled[d] = i%_grid[d];
+				i /= _grid[d];
+			}
+			func(static_cast<uint64_t const *>(&scaled[0]), chunk);
+		};
+
+		if (_table) {
+			for (uint64_t i = 0; i < _count; ++i)
+				visit(_table[i].linear, chunk_desc_t{_table[i].size, _table[i].filters, _table[i].address});
+		} else if (not _dense.empty()) {
+			for (uint64_t i = 0; i < _dense.size(); ++i) {
+				if (_dense[i].size_of_chunk != 0)
+					visit(i, _dense[i]);
+			}
+		} else {
+			vector<pair<uint64_t, chunk_desc_t>> tmp{_sparse.begin(), _sparse.end()};
+			sort(tmp.begin(), tmp.end(), [](pair<uint64_t, chunk_desc_t> const & a, pair<uint64_t, chunk_desc_t> const & b) { return a.first < b.first; });
+			for (auto const & x: tmp) {
+				visit(x.first, x.second);
+			}
+		}
+	}
+
+	// allocated chunks in grid order.
+	vector<chunk_desc_t> list() const
+	{
+		vector<chunk_desc_t> ret;
+		ret.reserve(_count);
+		if (_table) {
+			for (uint64_t i = 0; i < _count; ++i)
+				ret.emplace_back(_table[i].size, _table[i].filters, _table[i].address);
+		} else if (not _dense.empty()) {
+			for (auto const & x: _dense) {
+				if (x.size_of_chunk != 0)
+					ret.push_back(x);
+			}
+		} else {
+			vector<pair<uint64_t, chunk_desc_t>> tmp{_sparse.begin(), _sparse.end()};
+			sort(tmp.begin(), tmp.end(), [](pair<uint64_t, chunk_desc_t> const & a, pair<uint64_t, chunk_desc_t> const & b) { return a.first < b.first; });
+			for (auto const & x: tmp) {
+				ret.push_back(x.second);
+			}
+		}
+		return ret;
+	}
+
+	// allocated chunks with their linear index, in grid order.
+	vector<chunk_entry_t> flatten() const
+	{
+		vector<chunk_entry_t> ret;
+		ret.reserve(_count);
+		for_each([&](uint64_t const * scaled, chunk_desc_t const & chunk) {
+			ret.push_back(chunk_entry_t{linear_index(scaled), chunk.address, chunk.size_of_chunk, chunk.filters});
+		});
+		return ret;
+	}
+
+};
+
+} // h5ng
+
+#endif /* SRC_H5NG_CHUNK_INDEX_HXX_ */
@@ -0,0 +1,321 @@
+/*
+ * h5ng-convert.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_CONVERT_HXX_
+#define SRC_H5NG_CONVERT_HXX_
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#include "h5ng.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+/**
+ * Convert count elements from src to dst, strides are in bytes and a null
+ * source stride broadcast the source element.
+ **/
+using convert_row_func = void (*)(uint8_t * dst, int64_t dst_stride, uint8_t const * src, int64_t src_stride, int64_t count);
+
+template<size_t N>
+struct _bswap_uint;
+
+template<> struct _bswap_uint<1> {
+	using type = uint8_t;
+	static type run(type x) { return x; }
+};
+
+template<> struct _bswap_uint<2> {
+	using type = uint16_t;
+	static type run(type x) { return __builtin_bswap16(x); }
+};
+
+template<> struct _bswap_uint<4> {
+	using type = uint32_t;
+	static type run(type x) { return __builtin_bswap32(x); }
+};
+
+template<> struct _bswap_uint<8> {
+	using type = uint64_t;
+	static type run(type x) { return __builtin_bswap64(x); }
+};
+
+// reverse the byte order of x.
+template<typename T>
+static inline T bswap(T x)
+{
+	using U = _bswap_uint<sizeof(T)>;
+	typename U::type v;
+	std::memcpy(&v, &x, sizeof(T));
+	v = U::run(v);
+	std::memcpy(&x, &v, sizeof(T));
+	return x;
+}
+
+// load one source element, swapping bytes if needed.
+template<typename S, bool SWAP>
+static inline S load_element(uint8_t const * src)
+{
+	S x;
+	std::memcpy(&x, src, sizeof(S));
+	return SWAP ? bswap(x) : x;
+}
+
+// convert one element, with static_cast semantic.
+template<typename S, typename D>
+static inline auto convert_element(S x) -> typename enable_if<not (is_floating_point<S>::value and is_integral<D>::value), D>::type
+{
+	return static_cast<D>(x);
+}
+
+/**
+ * convert one floating-point element to an integer, the value is rounded
+ * toward zero and saturated to the range of D, NaN become 0. static_cast is
+ * undefined for NaN and out of range values.
+ **/
+template<typename S, typename D>
+static inline auto convert_element(S x) -> typename enable_if<is_floating_point<S>::value and is_integral<D>::value, D>::type
+{
+	if (x != x)
+		return 0;
+	if (x <= static_cast<S>(numeric_limits<D>::lowest()))
+		return numeric_limits<D>::lowest();
+	if (x >= static_cast<S>(numeric_limits<D>::max()))
+		return numeric_limits<D>::max();
+	return static_cast<D>(x);
+}
+
+/**
+ * SIMD conversion of step contiguous elements from S to D, specialized for
+ * the pairs that have a kernel on the target, step is 0 otherwise.
+ **/
+template<typename S, typename D, bool SWAP>
+struct simd_block {
+	enum : int64_t { step = 0 };
+	static void convert(uint8_t *, uint8_t const *) { }
+};
+
+#ifdef __SSE2__
+
+// swap bytes within each lane of size N.
+template<size_t N>
+static inline __m128i simd_bswap(__m128i x);
+
+template<>
+inline __m128i simd_bswap<1>(__m128i x)
+{
+	return x;
+}
+
+template<>
+inline __m128i simd_bswap<2>(__m128i x)
+{
+	return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+template<>
+inline __m128i simd_bswap<4>(__m128i x)
+{
+#ifdef __SSSE3__
+	return _mm_shuffle_epi8(x, _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3));
+#else
+	x = _mm_or_si128(_mm_slli_epi32(x, 16), _mm_srli_epi32(x, 16));
+	return simd_bswap<2>(x);
+#endif
+}
+
+template<>
+inline __m128i simd_bswap<8>(__m128i x)
+{
+#ifdef __SSSE3__
+	return _mm_shuffle_epi8(x, _mm_set_epi8(8,9,10,11,12,13,14,15, 0,1,2,3,4,5,6,7));
+#else
+	return simd_bswap<4>(_mm_shuffle_epi32(x, _MM_SHUFFLE(2,3,0,1)));
+#endif
+}
+
+template<size_t N, bool SWAP>
+static inline __m128i simd_load(uint8_t const * src)
+{
+	__m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src));
+	return SWAP ? simd_bswap<N>(x) : x;
+}
+
+// same type, only bytes are swapped.
+template<typename T>
+struct simd_block<T, T, true> {
+	enum : int64_t { step = (sizeof(T) > 1 and sizeof(T) <= 8) ? 16/sizeof(T) : 0 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), simd_load<sizeof(T), true>(src));
+	}
+};
+
+template<bool SWAP>
+struct simd_block<int16_t, float, SWAP> {
+	enum : int64_t { step = 8 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		__m128i x = simd_load<2, SWAP>(src);
+		// sign extend by placing the value in the high half then shifting.
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+		_mm_storeu_ps(reinterpret_cast<float *>(dst), _mm_cvtepi32_ps(lo));
+		_mm_storeu_ps(reinterpret_cast<float *>(dst)+4, _mm_cvtepi32_ps(hi));
+	}
+};
+
+template<bool SWAP>
+struct simd_block<uint16_t, float, SWAP> {
+	enum : int64_t { step = 8 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		__m128i x = simd_load<2, SWAP>(src);
+		__m128i zero = _mm_setzero_si128();
+		_mm_storeu_ps(reinterpret_cast<float *>(dst), _mm_cvtepi32_ps(_mm_unpacklo_epi16(x, zero)));
+		_mm_storeu_ps(reinterpret_cast<float *>(dst)+4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(x, zero)));
+	}
+};
+
+template<bool SWAP>
+struct simd_block<int32_t, float, SWAP> {
+	enum : int64_t { step = 4 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		_mm_storeu_ps(reinterpret_cast<float *>(dst), _mm_cvtepi32_ps(simd_load<4, SWAP>(src)));
+	}
+};
+
+template<bool SWAP>
+struct simd_block<int32_t, double, SWAP> {
+	enum : int64_t { step = 4 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		__m128i x = simd_load<4, SWAP>(src);
+		_mm_storeu_pd(reinterpret_cast<double *>(dst), _mm_cvtepi32_pd(x));
+		_mm_storeu_pd(reinterpret_cast<double *>(dst)+2, _mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(1,0,3,2))));
+	}
+};
+
+template<bool SWAP>
+struct simd_block<float, double, SWAP> {
+	enum : int64_t { step = 4 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		__m128 x = _mm_castsi128_ps(simd_load<4, SWAP>(src));
+		_mm_storeu_pd(reinterpret_cast<double *>(dst), _mm_cvtps_pd(x));
+		_mm_storeu_pd(reinterpret_cast<double *>(dst)+2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+	}
+};
+
+template<bool SWAP>
+struct simd_block<double, float, SWAP> {
+	enum : int64_t { step = 4 };
+	static void convert(uint8_t * dst, uint8_t const * src)
+	{
+		__m128 lo = _mm_cvtpd_ps(_mm_castsi128_pd(simd_load<8, SWAP>(src)));
+		__m128 hi = _mm_cvtpd_ps(_mm_castsi128_pd(simd_load<8, SWAP>(src+16)));
+		_mm_storeu_ps(reinterpret_cast<float *>(dst), _mm_movelh_ps(lo, hi));
+	}
+};
+
+#endif
+
+/**
+ * Convert a row of elements stored as S into D. Contiguous rows use the
+ * simd_block kernel of the pair if any, the remaining elements and strided
+ * rows are converted one by one.
+ **/
+template<typename S, typename D, bool SWAP>
+struct convert_kernel {
+	static void run(uint8_t * dst, int64_t dst_stride, uint8_t const * src, int64_t src_stride, int64_t count)
+	{
+		using block = simd_block<S, D, SWAP>;
+		int64_t i = 0;
+		if (block::step > 0 and src_stride == sizeof(S) and dst_stride == sizeof(D)) {
+			for (; i + block::step <= count; i += block::step) {
+				block::convert(dst + i*sizeof(D), src + i*sizeof(S));
+			}
+		}
+
+		for (; i < count; ++i) {
+			D x = convert_element<S, D>(load_element<S, SWAP>(src + i*src_stride));
+			std::memcpy(dst + i*dst_stride, &x, sizeof(D));
+		}
+	}
+};
+
+template<typename S, typename D>
+static convert_row_func _select_convert(bool swap)
+{
+	if (swap)
+		return &convert_kernel<S, D, true>::run;
+	if (std::is_same<S, D>::value)
+		return nullptr;
+	return &convert_kernel<S, D, false>::run;
+}
+
+/**
+ * Return the kernel that convert elements of the dataset type to D, nullptr
+ * if elements can be copied as is. Fixed-point and IEEE floating-point types
+ * of 1, 2, 4 or 8 bytes are supported, enumerated types are converted from
+ * their integer values. Floating-point values converted to an integer type
+ * are saturated, NaN become 0.
+ **/
+template<typename D>
+static convert_row_func select_convert(object_datatype_t const & datatype)
+{
+	static_assert(std::is_arithmetic<D>::value, "read conversion is only available to arithmetic types");
+
+	auto const & n = datatype.number;
+	if (not n.valid)
+		throw EXCEPTION("Unsupported datatype conversion from class %d", datatype.xclass);
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	bool swap = n.size > 1 and not n.big_endian;
+#else
+	bool swap = n.size > 1 and n.big_endian;
+#endif
+
+	if (n.floating) {
+		switch (n.size) {
+		case 4: return _select_convert<float, D>(swap);
+		case 8: return _select_convert<double, D>(swap);
+		}
+	} else if (n.is_signed) {
+		switch (n.size) {
+		case 1: return _select_convert<int8_t, D>(swap);
+		case 2: return _select_convert<int16_t, D>(swap);
+		case 4: return _select_convert<int32_t, D>(swap);
+		case 8: return _select_convert<int64_t, D>(swap);
+		}
+	} else {
+		switch (n.size) {
+		case 1: return _select_convert<uint8_t, D>(swap);
+		case 2: return _select_convert<uint16_t, D>(swap);
+		case 4: return _select_convert<uint32_t, D>(swap);
+		case 8: return _select_convert<uint64_t, D>(swap);
+		}
+	}
+
+	throw EXCEPTION("Unsupported datatype conversion from element of size %d", n.size);
+}
+
+} // h5ng
+
+#endif /* SRC_H5NG_CONVERT_HXX_ */
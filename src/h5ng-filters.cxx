@@ -0,0 +1,408 @@
+/*
+ * h5ng-filters.cxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#include "h5ng-filters.hxx"
+
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#include <zlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace h5ng {
+
+void filter_deflate_decode(uint8_t const * input, uint64_t size, vector<uint8_t> & output, uint64_t expected_size)
+{
+	z_stream z;
+	std::memset(&z, 0, sizeof(z));
+	z.next_in = const_cast<Bytef *>(input);
+	z.avail_in = 0;
+
+	if (inflateInit(&z) != Z_OK)
+		throw EXCEPTION("Fail to initialize zlib");
+
+	// zlib counts are 32 bits, buffers larger than UINT_MAX are given in slices.
+	uint8_t const * end = input+size;
+	output.resize(std::max<uint64_t>(expected_size, 1));
+	while (true) {
+		if (z.avail_in == 0)
+			z.avail_in = std::min<uint64_t>(end-z.next_in, UINT_MAX);
+		if (z.total_out == output.size()) // output too small
+			output.resize(output.size()*2);
+		z.next_out = &output[z.total_out];
+		z.avail_out = std::min<uint64_t>(output.size()-z.total_out, UINT_MAX);
+		int ret = inflate(&z, Z_SYNC_FLUSH);
+		if (ret == Z_STREAM_END)
+			break;
+		if (ret == Z_OK or ret == Z_BUF_ERROR) {
+			if (z.avail_out == 0 or (z.avail_in == 0 and z.next_in != end))
+				continue; // next slice
+			if (z.avail_in == 0) {
+				inflateEnd(&z);
+				throw EXCEPTION("Truncated deflate stream");
+			}
+		}
+		inflateEnd(&z);
+		throw EXCEPTION("Invalid deflate stream (%d)", ret);
+	}
+
+	output.resize(z.total_out);
+	inflateEnd(&z);
+}
+
+void filter_deflate_encode(uint8_t const * input, uint64_t size, vector<uint8_t> & output, int level)
+{
+	z_stream z;
+	std::memset(&z, 0, sizeof(z));
+
+	if (deflateInit(&z, level) != Z_OK)
+		throw EXCEPTION("Fail to initialize zlib");
+
+	output.resize(deflateBound(&z, size));
+	z.next_in = const_cast<Bytef *>(input);
+	z.next_out = &output[0];
+
+	// zlib counts are 32 bits, buffers larger than UINT_MAX are given in slices.
+	uint8_t const * end = input+size;
+	int ret;
+	do {
+		if (z.avail_in == 0)
+			z.avail_in = std::min<uint64_t>(end-z.next_in, UINT_MAX);
+		if (z.avail_out == 0)
+			z.avail_out = std::min<uint64_t>(output.size()-z.total_out, UINT_MAX);
+		ret = deflate(&z, z.next_in+z.avail_in == end ? Z_FINISH : Z_NO_FLUSH);
+	} while (ret == Z_OK);
+
+	if (ret != Z_STREAM_END) {
+		deflateEnd(&z);
+		throw EXCEPTION("Fail to deflate chunk (%d)", ret);
+	}
+
+	output.resize(z.total_out);
+	deflateEnd(&z);
+}
+
+template<unsigned S>
+static void _shuffle(uint8_t const * input, uint8_t * output, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; ++i) {
+		for (unsigned k = 0; k < S; ++k) {
+			output[k*count+i] = input[i*S+k];
+		}
+	}
+}
+
+static void _shuffle(uint8_t const * input, uint8_t * output, uint64_t count, uint64_t element_size)
+{
+	for (uint64_t i = 0; i < count; ++i) {
+		for (uint64_t k = 0; k < element_size; ++k) {
+			output[k*count+i] = input[i*element_size+k];
+		}
+	}
+}
+
+void filter_shuffle_encode(uint8_t const * input, uint64_t size, uint8_t * output, uint64_t element_size)
+{
+	if (element_size <= 1 or size < element_size) {
+		std::memcpy(output, input, size);
+		return;
+	}
+
+	uint64_t count = size/element_size;
+
+	switch (element_size) {
+	case 2: _shuffle<2>(input, output, count); break;
+	case 4: _shuffle<4>(input, output, count); break;
+	case 8: _shuffle<8>(input, output, count); break;
+	default: _shuffle(input, output, count, element_size); break;
+	}
+
+	// bytes that do not fit an element are not shuffled.
+	uint64_t leftover = size%element_size;
+	std::memcpy(&output[size-leftover], &input[size-leftover], leftover);
+}
+
+// Generic version, with the element size known at compile time the inner loop is unrolled.
+template<unsigned S>
+static void _unshuffle(uint8_t const * input, uint8_t * output, uint64_t count, uint64_t start)
+{
+	for (uint64_t i = start; i < count; ++i) {
+		for (unsigned b = 0; b < S; ++b) {
+			output[i*S+b] = input[b*count+i];
+		}
+	}
+}
+
+static void _unshuffle(uint8_t const * input, uint8_t * output, uint64_t count, uint64_t element_size)
+{
+	for (uint64_t b = 0; b < element_size; ++b) {
+		uint8_t const * plane = &input[b*count];
+		for (uint64_t i = 0; i < count; ++i) {
+			output[i*element_size+b] = plane[i];
+		}
+	}
+}
+
+#ifdef __SSE2__
+
+// The SSE2 kernels process 16 elements per iteration and return the number of
+// processed elements, the remaining elements are handled by the generic version.
+
+static uint64_t _unshuffle_sse2_2(uint8_t const * input, uint8_t * output, uint64_t count)
+{
+	uint8_t const * p0 = &input[0*count];
+	uint8_t const * p1 = &input[1*count];
+	uint64_t i = 0;
+	for (; i+16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p0+i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p1+i));
+		__m128i * out = reinterpret_cast<__m128i *>(output+i*2);
+		_mm_storeu_si128(out+0, _mm_unpacklo_epi8(a, b));
+		_mm_storeu_si128(out+1, _mm_unpackhi_epi8(a, b));
+	}
+	return i;
+}
+
+static uint64_t _unshuffle_sse2_4(uint8_t const * input, uint8_t * output, uint64_t count)
+{
+	uint8_t const * p0 = &input[0*count];
+	uint8_t const * p1 = &input[1*count];
+	uint8_t const * p2 = &input[2*count];
+	uint8_t const * p3 = &input[3*count];
+	uint64_t i = 0;
+	for (; i+16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p0+i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p1+i));
+		__m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p2+i));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p3+i));
+		__m128i ab_lo = _mm_unpacklo_epi8(a, b);
+		__m128i ab_hi = _mm_unpackhi_epi8(a, b);
+		__m128i cd_lo = _mm_unpacklo_epi8(c, d);
+		__m128i cd_hi = _mm_unpackhi_epi8(c, d);
+		__m128i * out = reinterpret_cast<__m128i *>(output+i*4);
+		_mm_storeu_si128(out+0, _mm_unpacklo_epi16(ab_lo, cd_lo));
+		_mm_storeu_si128(out+1, _mm_unpackhi_epi16(ab_lo, cd_lo));
+		_mm_storeu_si128(out+2, _mm_unpacklo_epi16(ab_hi, cd_hi));
+		_mm_storeu_si128(out+3, _mm_unpackhi_epi16(ab_hi, cd_hi));
+	}
+	return i;
+}
+
+static uint64_t _unshuffle_sse2_8(uint8_t const * input, uint8_t * output, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i+16 <= count; i += 16) {
+		__m128i x[8];
+		for (unsigned k = 0; k < 8; ++k) {
+			x[k] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&input[k*count+i]));
+		}
+
+		// pairs of bytes
+		__m128i lo[4], hi[4];
+		for (unsigned k = 0; k < 4; ++k) {
+			lo[k] = _mm_unpacklo_epi8(x[2*k], x[2*k+1]);
+			hi[k] = _mm_unpackhi_epi8(x[2*k], x[2*k+1]);
+		}
+
+		// 4 bytes groups, bytes 0-3 in a, bytes 4-7 in b
+		__m128i a[4], b[4];
+		a[0] = _mm_unpacklo_epi16(lo[0], lo[1]);
+		a[1] = _mm_unpackhi_epi16(lo[0], lo[1]);
+		a[2] = _mm_unpacklo_epi16(hi[0], hi[1]);
+		a[3] = _mm_unpackhi_epi16(hi[0], hi[1]);
+		b[0] = _mm_unpacklo_epi16(lo[2], lo[3]);
+		b[1] = _mm_unpackhi_epi16(lo[2], lo[3]);
+		b[2] = _mm_unpacklo_epi16(hi[2], hi[3]);
+		b[3] = _mm_unpackhi_epi16(hi[2], hi[3]);
+
+		__m128i * out = reinterpret_cast<__m128i *>(output+i*8);
+		for (unsigned k = 0; k < 4; ++k) {
+			_mm_storeu_si128(out+2*k+0, _mm_unpacklo_epi32(a[k], b[k]));
+			_mm_storeu_si128(out+2*k+1, _mm_unpackhi_epi32(a[k], b[k]));
+		}
+	}
+	return i;
+}
+
+#endif
+
+void filter_shuffle_decode(uint8_t const * input, uint64_t size, uint8_t * output, uint64_t element_size)
+{
+	if (element_size <= 1 or size < element_size) {
+		std::memcpy(output, input, size);
+		return;
+	}
+
+	uint64_t count = size/element_size;
+
+	switch (element_size) {
+#ifdef __SSE2__
+	case 2: _unshuffle<2>(input, output, count, _unshuffle_sse2_2(input, output, count)); break;
+	case 4: _unshuffle<4>(input, output, count, _unshuffle_sse2_4(input, output, count)); break;
+	case 8: _unshuffle<8>(input, output, count, _unshuffle_sse2_8(input, output, count)); break;
+#else
+	case 2: _unshuffle<2>(input, output, count, 0); break;
+	case 4: _unshuffle<4>(input, output, count, 0); break;
+	case 8: _unshuffle<8>(input, output, count, 0); break;
+#endif
+	default: _unshuffle(input, output, count, element_size); break;
+	}
+
+	// bytes that do not fit an element are not shuffled.
+	uint64_t leftover = size%element_size;
+	std::memcpy(&output[size-leftover], &input[size-leftover], leftover);
+}
+
+uint32_t filter_fletcher32_checksum(uint8_t const * data, uint64_t size)
+{
+	uint64_t len = size/2;
+	uint32_t sum1 = 0;
+	uint32_t sum2 = 0;
+
+	// 360 is the largest number of sums that can be performed without overflow.
+	while (len) {
+		uint64_t tlen = len > 360 ? 360 : len;
+		len -= tlen;
+		do {
+			sum1 += (static_cast<uint32_t>(data[0]) << 8) | static_cast<uint32_t>(data[1]);
+			data += 2;
+			sum2 += sum1;
+		} while (--tlen);
+		sum1 = (sum1 & 0xffffu) + (sum1 >> 16);
+		sum2 = (sum2 & 0xffffu) + (sum2 >> 16);
+	}
+
+	// odd size, the last byte is padded with zero.
+	if (size%2) {
+		sum1 += static_cast<uint32_t>(data[0]) << 8;
+		sum2 += sum1;
+		sum1 = (sum1 & 0xffffu) + (sum1 >> 16);
+		sum2 = (sum2 & 0xffffu) + (sum2 >> 16);
+	}
+
+	sum1 = (sum1 & 0xffffu) + (sum1 >> 16);
+	sum2 = (sum2 & 0xffffu) + (sum2 >> 16);
+
+	return (sum2 << 16) | sum1;
+}
+
+uint64_t filter_fletcher32_decode(uint8_t const * input, uint64_t size)
+{
+	if (size < 4)
+		throw EXCEPTION("Chunk too small for fletcher32 checksum (%lu)", size);
+
+	uint64_t data_size = size-4;
+	uint32_t stored = static_cast<uint32_t>(input[data_size+0])
+			| static_cast<uint32_t>(input[data_size+1]) << 8
+			| static_cast<uint32_t>(input[data_size+2]) << 16
+			| static_cast<uint32_t>(input[data_size+3]) << 24;
+
+	uint32_t checksum = filter_fletcher32_checksum(input, data_size);
+
+	// HDF5 before 1.6.3 swapped bytes within each half of the checksum.
+	uint32_t reversed = ((checksum & 0x00ff00ffu) << 8) | ((checksum & 0xff00ff00u) >> 8);
+
+	if (stored != checksum and stored != reversed)
+		throw EXCEPTION("Fletcher32 checksum mismatch (0x%08x != 0x%08x)", stored, checksum);
+
+	return data_size;
+}
+
+void filter_pipeline_decode(object_data_storage_filter_pipeline_t const & pipeline, uint32_t filter_mask,
+		uint8_t const * input, uint64_t size, vector<uint8_t> & output, vector<uint8_t> & tmp, uint64_t expected_size)
+{
+	// cur is the current data, it is stored in input or in one of output or tmp.
+	uint8_t const * cur = input;
+	vector<uint8_t> * cur_buffer = nullptr;
+
+	for (size_t i = pipeline.filters.size(); i-- > 0;) {
+		if (i < 32 and (filter_mask & (1u << i)))
+			continue; // the filter was not applied to this chunk.
+
+		auto const & filter = pipeline.filters[i];
+		vector<uint8_t> * dst = (cur_buffer == &output) ? &tmp : &output;
+
+		switch (filter.id) {
+		case FILTER_DEFLATE:
+			filter_deflate_decode(cur, size, *dst, expected_size);
+			size = dst->size();
+			cur = &(*dst)[0];
+			cur_buffer = dst;
+			break;
+		case FILTER_SHUFFLE:
+			dst->resize(size);
+			filter_shuffle_decode(cur, size, &(*dst)[0], filter.params.size() > 0 ? filter.params[0] : 1);
+			cur = &(*dst)[0];
+			cur_buffer = dst;
+			break;
+		case FILTER_FLETCHER32:
+			size = filter_fletcher32_decode(cur, size);
+			break;
+		default:
+			throw EXCEPTION("Unsupported filter `%s' (%d)", filter.name.c_str(), filter.id);
+		}
+	}
+
+	if (size != expected_size)
+		throw EXCEPTION("Decoded chunk size mismatch (%lu != %lu)", size, expected_size);
+
+	if (cur_buffer != &output) {
+		output.assign(cur, cur+size);
+	} else {
+		output.resize(size);
+	}
+
+}
+
+void filter_pipeline_encode(object_data_storage_filter_pipeline_t const & pipeline,
+		uint8_t const * input, uint64_t size, vector<uint8_t> & output, vector<uint8_t> & tmp)
+{
+	uint8_t const * cur = input;
+	vector<uint8_t> * cur_buffer = nullptr;
+
+	for (auto const & filter: pipeline.filters) {
+		vector<uint8_t> * dst = (cur_buffer == &output) ? &tmp : &output;
+
+		switch (filter.id) {
+		case FILTER_DEFLATE:
+			filter_deflate_encode(cur, size, *dst, filter.params.size() > 0 ? filter.params[0] : Z_DEFAULT_COMPRESSION);
+			size = dst->size();
+			break;
+		case FILTER_SHUFFLE:
+			dst->resize(size);
+			filter_shuffle_encode(cur, size, &(*dst)[0], filter.params.size() > 0 ? filter.params[0] : 1);
+			break;
+		case FILTER_FLETCHER32: {
+			uint32_t checksum = filter_fletcher32_checksum(cur, size);
+			dst->resize(size+4);
+			std::memcpy(&(*dst)[0], cur, size);
+			for (unsigned k = 0; k < 4; ++k)
+				(*dst)[size+k] = (checksum >> (8*k)) & 0xffu;
+			size += 4;
+			break;
+		}
+		default:
+			throw EXCEPTION("Unsupported filter `%s' (%d)", filter.name.c_str(), filter.id);
+		}
+
+		cur = &(*dst)[0];
+		cur_buffer = dst;
+	}
+
+	if (cur_buffer != &output) {
+		output.assign(cur, cur+size);
+	} else {
+		output.resize(size);
+	}
+
+}
+
+} // h5ng
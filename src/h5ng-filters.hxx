@@ -0,0 +1,69 @@
+/*
+ * h5ng-filters.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_FILTERS_HXX_
+#define SRC_H5NG_FILTERS_HXX_
+
+#include <cstdint>
+#include <vector>
+
+#include "h5ng.hxx"
+#include "exception.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+enum filter_id_e : uint16_t {
+	FILTER_DEFLATE                         = 1u,
+	FILTER_SHUFFLE                         = 2u,
+	FILTER_FLETCHER32                      = 3u,
+	FILTER_SZIP                            = 4u,
+	FILTER_NBIT                            = 5u,
+	FILTER_SCALEOFFSET                     = 6u
+};
+
+// Inflate a zlib stream, output is resized to the decoded size.
+void filter_deflate_decode(uint8_t const * input, uint64_t size, vector<uint8_t> & output, uint64_t expected_size);
+
+// Deflate with zlib at the given level, output is resized to the encoded size.
+void filter_deflate_encode(uint8_t const * input, uint64_t size, vector<uint8_t> & output, int level);
+
+// Reverse the byte shuffle of elements of element_size bytes.
+void filter_shuffle_decode(uint8_t const * input, uint64_t size, uint8_t * output, uint64_t element_size);
+
+// Byte shuffle elements of element_size bytes, the first bytes of all elements come first.
+void filter_shuffle_encode(uint8_t const * input, uint64_t size, uint8_t * output, uint64_t element_size);
+
+// Fletcher32 checksum as computed by the HDF5 reference implementation.
+uint32_t filter_fletcher32_checksum(uint8_t const * data, uint64_t size);
+
+// Check the trailing checksum, return the size of data without the checksum.
+uint64_t filter_fletcher32_decode(uint8_t const * input, uint64_t size);
+
+/**
+ * Decode a chunk through the filter pipeline, filters are applied in reverse
+ * order and the filter i is skipped if the bit i of filter_mask is set.
+ *
+ * The decoded chunk is stored in output, tmp is used as scratch buffer, both
+ * are resized as needed and can be reused between calls.
+ **/
+void filter_pipeline_decode(object_data_storage_filter_pipeline_t const & pipeline, uint32_t filter_mask,
+		uint8_t const * input, uint64_t size, vector<uint8_t> & output, vector<uint8_t> & tmp, uint64_t expected_size);
+
+/**
+ * Encode a chunk through the filter pipeline, filters are applied in order.
+ *
+ * The encoded chunk is stored in output, tmp is used as scratch buffer, both
+ * are resized as needed and can be reused between calls.
+ **/
+void filter_pipeline_encode(object_data_storage_filter_pipeline_t const & pipeline,
+		uint8_t const * input, uint64_t size, vector<uint8_t> & output, vector<uint8_t> & tmp);
+
+} // h5ng
+
+#endif /* SRC_H5NG_FILTERS_HXX_ */
@@ -0,0 +1,784 @@
+/*
+ * h5ng-index.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_INDEX_HXX_
+#define SRC_H5NG_INDEX_HXX_
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "h5ng.hxx"
+#include "h5ng-chunk-index.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+/**
+ * Sidecar metadata index.
+ *
+ * The index store the decoded metadata of every object reachable from the
+ * root group, the links of groups and the flattened chunk tables of chunked
+ * datasets, thus a file can be reopened without parsing object headers nor
+ * walking chunk B-trees. The index is a single block of tables that is
+ * mapped read-only, tables are used in place. Values are stored in the byte
+ * order of the host that built the index, the header record it with a tag
+ * and an index of another byte order is rejected.
+ *
+ * The index is only valid for the file it was built from, it records the
+ * size and the modification time of the file and is ignored if they differ.
+ **/
+
+// name of the sidecar index of a file.
+static inline string index_filename(string const & filename)
+{
+	return filename + ".h5ngidx";
+}
+
+struct index_table_t {
+	uint64_t offset;   //< from the start of the index, 8 bytes aligned
+	uint64_t count;
+};
+
+struct index_header_t {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t byte_order;       //< INDEX_BYTE_ORDER written in the byte order of the tables
+	uint32_t reserved;
+	uint64_t size;             //< size of the whole index
+	uint64_t file_size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t root;             //< address of the root group header
+	index_table_t objects;     //< index_object_t sorted by address
+	index_table_t links;       //< index_link_t of each group, in the order of keys()
+	index_table_t link_order;  //< uint32_t, position of the links of each group sorted by name
+	index_table_t paths;       //< index_path_t sorted by path
+	index_table_t chunks;      //< chunk_entry_t of each dataset, in grid order
+	index_table_t metadata;    //< encoded object metadata, count in bytes
+	index_table_t strings;     //< names and paths, count in bytes
+};
+
+struct index_object_t {
+	uint64_t address;          //< address of the object header
+	uint64_t metadata;         //< offset of the encoded metadata within the metadata table
+	uint64_t metadata_size;
+	uint64_t first_link;       //< also the first entry of link_order
+	uint64_t link_count;
+	uint64_t first_chunk;
+	uint64_t chunk_count;
+	uint32_t flags;
+	uint32_t reserved;
+
+	enum : uint32_t {
+		HAS_CHUNKS = 0x1u      //< the chunk table is set, otherwise the chunk index is built on demand
+	};
+};
+
+struct index_link_t {
+	uint64_t address;          //< all bits set for soft and external links
+	uint64_t name;             //< offset of the name within the string table
+	uint32_t name_size;
+	uint32_t type;
+};
+
+// canonical path of an object, i.e. the first path found in breadth-first order.
+struct index_path_t {
+	uint64_t name;
+	uint64_t name_size;
+	uint64_t address;
+};
+
+static char const INDEX_MAGIC[8] = {'H', '5', 'N', 'G', 'I', 'D', 'X', '\0'};
+enum : uint32_t { INDEX_VERSION = 2u };
+enum : uint32_t { INDEX_BYTE_ORDER = 0x01020304u };
+
+// Append raw values to an encoded metadata block.
+struct _index_encoder {
+	vector<uint8_t> & out;
+
+	template<typename T>
+	void put(T const & x)
+	{
+		auto p = reinterpret_cast<uint8_t const *>(&x);
+		out.insert(out.end(), p, p+sizeof(T));
+	}
+
+	template<typename T>
+	void put_vector(vector<T> const & x)
+	{
+		put<uint64_t>(x.size());
+		for (auto const & v: x)
+			put<T>(v);
+	}
+
+	void put_string(string const & x)
+	{
+		put<uint64_t>(x.size());
+		out.insert(out.end(), x.begin(), x.end());
+	}
+
+};
+
+// Read values of an encoded metadata block, throw if the block is truncated.
+struct _index_decoder {
+	uint8_t const * cur;
+	uint8_t const * end;
+
+	void _need(uint64_t size)
+	{
+		if (size > static_cast<uint64_t>(end-cur))
+			throw EXCEPTION("Corrupted metadata index");
+	}
+
+	template<typename T>
+	T get()
+	{
+		T ret;
+		_need(sizeof(T));
+		memcpy(&ret, cur, sizeof(T));
+		cur += sizeof(T);
+		return ret;
+	}
+
+	template<typename T>
+	void get_vector(vector<T> & x)
+	{
+		uint64_t n = get<uint64_t>();
+		_need(n*sizeof(T));
+		x.resize(n);
+		for (auto & v: x)
+			v = get<T>();
+	}
+
+	string get_string()
+	{
+		uint64_t n = get<uint64_t>();
+		_need(n);
+		string ret{reinterpret_cast<char const *>(cur), n};
+		cur += n;
+		return ret;
+	}
+
+};
+
+enum : uint8_t {
+	_INDEX_HAS_DATASPACE     = 0x01u,
+	_INDEX_HAS_DATATYPE      = 0x02u,
+	_INDEX_HAS_DATALAYOUT    = 0x04u,
+	_INDEX_HAS_FILLVALUE_OLD = 0x08u,
+	_INDEX_HAS_FILLVALUE     = 0x10u
+};
+
+/**
+ * Encode the messages of an object, links are stored apart and are not
+ * encoded, only fields used by the layout class are encoded.
+ **/
+static inline void index_encode_metadata(vector<uint8_t> & out, object_metadata_t const & x)
+{
+	_index_encoder e{out};
+
+	uint8_t flags = 0;
+	if (x.has_dataspace) flags |= _INDEX_HAS_DATASPACE;
+	if (x.has_datatype) flags |= _INDEX_HAS_DATATYPE;
+	if (x.has_datalayout) flags |= _INDEX_HAS_DATALAYOUT;
+	if (x.has_fillvalue_old) flags |= _INDEX_HAS_FILLVALUE_OLD;
+	if (x.has_fillvalue) flags |= _INDEX_HAS_FILLVALUE;
+	e.put<uint8_t>(flags);
+
+	if (x.has_dataspace) {
+		e.put<uint8_t>(x.dataspace.rank);
+		e.put_vector(x.dataspace.shape);
+		e.put_vector(x.dataspace.max_shape);
+		e.put_vector(x.dataspace.permutation);
+	}
+
+	if (x.has_datatype) {
+		e.put<uint8_t>(x.datatype.version);
+		e.put<uint8_t>(x.datatype.xclass);
+		e.put<uint32_t>(x.datatype.flags.to_ulong());
+		e.put<uint32_t>(x.datatype.size_of_elements);
+		e.put<uint8_t>(x.datatype.number.valid);
+		e.put<uint8_t>(x.datatype.number.floating);
+		e.put<uint8_t>(x.datatype.number.is_signed);
+		e.put<uint8_t>(x.datatype.number.big_endian);
+		e.put<uint32_t>(x.datatype.number.size);
+	}
+
+	if (x.has_datalayout) {
+		using tns = object_datalayout_t;
+		auto const & l = x.datalayout;
+		e.put<uint8_t>(l.version);
+		e.put<uint8_t>(l.layout_class);
+		switch (l.layout_class) {
+		case tns::LAYOUT_COMPACT:
+			e.put<uint8_t>(l.compact_dimensionality);
+			e.put<uint64_t>(l.compact_data_address);
+			e.put<uint32_t>(l.compact_data_size);
+			e.put_vector(l.compact_shape);
+			break;
+		case tns::LAYOUT_CONTIGUOUS:
+			e.put<uint8_t>(l.contiguous_dimensionality);
+			e.put<uint64_t>(l.contiguous_data_address);
+			e.put_vector(l.contiguous_shape);
+			e.put<uint64_t>(l.contiguous_data_size);
+			break;
+		case tns::LAYOUT_CHUNKED:
+			e.put<uint8_t>(l.chunk_flags);
+			e.put<uint8_t>(l.chunk_dimensionality);
+			e.put<uint8_t>(l.chunk_indexing_type);
+			e.put_vector(l.chunk_shape);
+			e.put<uint32_t>(l.chunk_size_of_element);
+			switch (l.chunk_indexing_type) {
+			case tns::CHUNK_INDEXING_BTREE_V1:
+				e.put<uint64_t>(l.chunk_btree_v1.data_address);
+				break;
+			case tns::CHUNK_INDEXING_SINGLE_CHUNK:
+				e.put<uint64_t>(l.chunk_single_chunk.size_of_filtered_chunk);
+				e.put<uint32_t>(l.chunk_single_chunk.filters);
+				e.put<uint64_t>(l.chunk_single_chunk.data_address);
+				break;
+			case tns::CHUNK_INDEXING_IMPLICIT:
+				e.put<uint64_t>(l.chunk_implicit.data_address);
+				break;
+			case tns::CHUNK_INDEXING_FIXED_ARRAY:
+				e.put<uint8_t>(l.chunk_fixed_array.page_bits);
+				e.put<uint64_t>(l.chunk_fixed_array.data_address);
+				break;
+			case tns::CHUNK_INDEXING_EXTENSIBLE_ARRAY:
+				e.put<uint8_t>(l.chunk_extensible_array.max_bits);
+				e.put<uint8_t>(l.chunk_extensible_array.index_elements);
+				e.put<uint8_t>(l.chunk_extensible_array.min_pointers);
+				e.put<uint8_t>(l.chunk_extensible_array.min_elements);
+				e.put<uint16_t>(l.chunk_extensible_array.page_bits);
+				e.put<uint64_t>(l.chunk_extensible_array.data_address);
+				break;
+			case tns::CHUNK_INDEXING_BTREE_V2:
+				e.put<uint32_t>(l.chunk_btree_v2.node_size);
+				e.put<uint8_t>(l.chunk_btree_v2.split_percent);
+				e.put<uint8_t>(l.chunk_btree_v2.merge_percent);
+				e.put<uint64_t>(l.chunk_btree_v2.data_address);
+				break;
+			}
+			break;
+		}
+	}
+
+	if (x.has_fillvalue_old)
+		e.put_vector(x.fillvalue_old.value);
+
+	if (x.has_fillvalue) {
+		e.put<uint8_t>(x.fillvalue.flags.to_ulong());
+		e.put_vector(x.fillvalue.value);
+	}
+
+	e.put<uint64_t>(x.filter_pipeline.filters.size());
+	for (auto const & f: x.filter_pipeline.filters) {
+		e.put<uint16_t>(f.id);
+		e.put_string(f.name);
+		e.put<uint16_t>(f.flags.to_ulong());
+		e.put_vector(f.params);
+	}
+}
+
+static inline void index_decode_metadata(uint8_t const * data, uint64_t size, object_metadata_t & x)
+{
+	_index_decoder d{data, data+size};
+
+	uint8_t flags = d.get<uint8_t>();
+	x.has_dataspace = flags & _INDEX_HAS_DATASPACE;
+	x.has_datatype = flags & _INDEX_HAS_DATATYPE;
+	x.has_datalayout = flags & _INDEX_HAS_DATALAYOUT;
+	x.has_fillvalue_old = flags & _INDEX_HAS_FILLVALUE_OLD;
+	x.has_fillvalue = flags & _INDEX_HAS_FILLVALUE;
+
+	if (x.has_dataspace) {
+		x.dataspace.rank = d.get<uint8_t>();
+		d.get_vector(x.dataspace.shape);
+		d.get_vector(x.dataspace.max_shape);
+		d.get_vector(x.dataspace.permutation);
+	}
+
+	if (x.has_datatype) {
+		x.datatype.version = d.get<uint8_t>();
+		x.datatype.xclass = d.get<uint8_t>();
+		x.datatype.flags = d.get<uint32_t>();
+		x.datatype.size_of_elements = d.get<uint32_t>();
+		x.datatype.number.valid = d.get<uint8_t>();
+		x.datatype.number.floating = d.get<uint8_t>();
+		x.datatype.number.is_signed = d.get<uint8_t>();
+		x.datatype.number.big_endian = d.get<uint8_t>();
+		x.datatype.number.size = d.get<uint32_t>();
+	}
+
+	if (x.has_datalayout) {
+		using tns = object_datalayout_t;
+		auto & l = x.datalayout;
+		l.version = d.get<uint8_t>();
+		l.layout_class = d.get<uint8_t>();
+		switch (l.layout_class) {
+		case tns::LAYOUT_COMPACT:
+			l.compact_dimensionality = d.get<uint8_t>();
+			l.compact_data_address = d.get<uint64_t>();
+			l.compact_data_size = d.get<uint32_t>();
+			d.get_vector(l.compact_shape);
+			break;
+		case tns::LAYOUT_CONTIGUOUS:
+			l.contiguous_dimensionality = d.get<uint8_t>();
+			l.contiguous_data_address = d.get<uint64_t>();
+			d.get_vector(l.contiguous_shape);
+			l.contiguous_data_size = d.get<uint64_t>();
+			break;
+		case tns::LAYOUT_CHUNKED:
+			l.chunk_flags = d.get<uint8_t>();
+			l.chunk_dimensionality = d.get<uint8_t>();
+			l.chunk_indexing_type = d.get<uint8_t>();
+			d.get_vector(l.chunk_shape);
+			l.chunk_size_of_element = d.get<uint32_t>();
+			switch (l.chunk_indexing_type) {
+			case tns::CHUNK_INDEXING_BTREE_V1:
+				l.chunk_btree_v1.data_address = d.get<uint64_t>();
+				break;
+			case tns::CHUNK_INDEXING_SINGLE_CHUNK:
+				l.chunk_single_chunk.size_of_filtered_chunk = d.get<uint64_t>();
+				l.chunk_single_chunk.filters = d.get<uint32_t>();
+				l.chunk_single_chunk.data_address = d.get<uint64_t>();
+				break;
+			case tns::CHUNK_INDEXING_IMPLICIT:
+				l.chunk_implicit.data_address = d.get<uint64_t>();
+				break;
+			case tns::CHUNK_INDEXING_FIXED_ARRAY:
+				l.chunk_fixed_array.page_bits = d.get<uint8_t>();
+				l.chunk_fixed_array.data_address = d.get<uint64_t>();
+				break;
+			case tns::CHUNK_INDEXING_EXTENSIBLE_ARRAY:
+				l.chunk_extensible_array.max_bits = d.get<uint8_t>();
+				l.chunk_extensible_array.index_elements = d.get<uint8_t>();
+				l.chunk_extensible_array.min_pointers = d.get<uint8_t>();
+				l.chunk_extensible_array.min_elements = d.get<uint8_t>();
+				l.chunk_extensible_array.page_bits = d.get<uint16_t>();
+				l.chunk_extensible_array.data_address = d.get<uint64_t>();
+				break;
+			case tns::CHUNK_INDEXING_BTREE_V2:
+				l.chunk_btree_v2.node_size = d.get<uint32_t>();
+				l.chunk_btree_v2.split_percent = d.get<uint8_t>();
+				l.chunk_btree_v2.merge_percent = d.get<uint8_t>();
+				l.chunk_btree_v2.data_address = d.get<uint64_t>();
+				break;
+			}
+			break;
+		}
+	}
+
+	if (x.has_fillvalue_old)
+		d.get_vector(x.fillvalue_old.value);
+
+	if (x.has_fillvalue) {
+		x.fillvalue.flags = d.get<uint8_t>();
+		d.get_vector(x.fillvalue.value);
+	}
+
+	uint64_t filter_count = d.get<uint64_t>();
+	for (uint64_t i = 0; i < filter_count; ++i) {
+		uint16_t id = d.get<uint16_t>();
+		string name = d.get_string();
+		uint16_t flags = d.get<uint16_t>();
+		vector<uint32_t> params;
+		d.get_vector(params);
+		x.filter_pipeline.filters.emplace_back(id, name, flags, params);
+	}
+}
+
+/**
+ * Read-only index, either mapped from a sidecar file or built in memory.
+ * Tables are checked when the index is loaded, thus accessors do not check
+ * bounds again. The index can be shared by all threads.
+ **/
+class metadata_index {
+	void * _map;
+	uint64_t _map_size;
+	vector<uint8_t> _buffer;
+
+	uint8_t const * _data;
+	uint64_t _size;
+	index_header_t const * _header;
+
+	template<typename T>
+	T const * _table(index_table_t const & t) const
+	{
+		return reinterpret_cast<T const *>(_data+t.offset);
+	}
+
+	char const * _string(uint64_t offset) const
+	{
+		return reinterpret_cast<char const *>(_data+_header->strings.offset+offset);
+	}
+
+	static int _compare(char const * a, uint64_t a_size, char const * b, uint64_t b_size)
+	{
+		int c = memcmp(a, b, std::min(a_size, b_size));
+		if (c != 0)
+			return c;
+		return a_size < b_size ? -1 : (a_size > b_size ? 1 : 0);
+	}
+
+	void _check_table(index_table_t const & t, uint64_t element_size) const
+	{
+		if (t.offset%8 != 0 or t.offset > _size or t.count > (_size-t.offset)/element_size)
+			throw EXCEPTION("Corrupted metadata index");
+	}
+
+	void _check_range(uint64_t first, uint64_t count, uint64_t table_count) const
+	{
+		if (first > table_count or count > table_count-first)
+			throw EXCEPTION("Corrupted metadata index");
+	}
+
+	void _check()
+	{
+		if (_size < sizeof(index_header_t))
+			throw EXCEPTION("Metadata index is truncated");
+		_header = reinterpret_cast<index_header_t const *>(_data);
+		if (memcmp(_header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+			throw EXCEPTION("Not a metadata index");
+		if (_header->version != INDEX_VERSION or _header->header_size != sizeof(index_header_t))
+			throw EXCEPTION("Unsupported metadata index version (%d)", _header->version);
+		if (_header->byte_order != INDEX_BYTE_ORDER)
+			throw EXCEPTION("Metadata index has another byte order");
+		if (_header->size != _size)
+			throw EXCEPTION("Metadata index is truncated");
+
+		_check_table(_header->objects, sizeof(index_object_t));
+		_check_table(_header->links, sizeof(index_link_t));
+		_check_table(_header->link_order, sizeof(uint32_t));
+		_check_table(_header->paths, sizeof(index_path_t));
+		_check_table(_header->chunks, sizeof(chunk_entry_t));
+		_check_table(_header->metadata, 1);
+		_check_table(_header->strings, 1);
+		if (_header->link_order.count != _header->links.count)
+			throw EXCEPTION("Corrupted metadata index");
+
+		auto strings = _header->strings.count;
+		auto objects = _table<index_object_t>(_header->objects);
+		for (uint64_t i = 0; i < _header->objects.count; ++i) {
+			auto const & x = objects[i];
+			if (i > 0 and objects[i-1].address >= x.address)
+				throw EXCEPTION("Corrupted metadata index");
+			_check_range(x.metadata, x.metadata_size, _header->metadata.count);
+			_check_range(x.first_link, x.link_count, _header->links.count);
+			_check_range(x.first_chunk, x.chunk_count, _header->chunks.count);
+			auto order = _table<uint32_t>(_header->link_order)+x.first_link;
+			for (uint64_t k = 0; k < x.link_count; ++k) {
+				if (order[k] >= x.link_count)
+					throw EXCEPTION("Corrupted metadata index");
+			}
+		}
+
+		auto links = _table<index_link_t>(_header->links);
+		for (uint64_t i = 0; i < _header->links.count; ++i)
+			_check_range(links[i].name, links[i].name_size, strings);
+
+		auto paths = _table<index_path_t>(_header->paths);
+		for (uint64_t i = 0; i < _header->paths.count; ++i)
+			_check_range(paths[i].name, paths[i].name_size, strings);
+	}
+
+public:
+
+	// use an index built in memory.
+	explicit metadata_index(vector<uint8_t> && buffer) :
+		_map{nullptr}, _map_size{0}, _buffer{std::move(buffer)}
+	{
+		_data = _buffer.data();
+		_size = _buffer.size();
+		_check();
+	}
+
+	// map the index file, throw if the file is missing or is not a valid index.
+	explicit metadata_index(string const & filename) :
+		_map{nullptr}, _map_size{0}
+	{
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw EXCEPTION("Fail to open file `%s'", filename.c_str());
+		struct stat st;
+		if (fstat(fd, &st) < 0 or st.st_size < static_cast<off_t>(sizeof(index_header_t))) {
+			close(fd);
+			throw EXCEPTION("Invalid metadata index `%s'", filename.c_str());
+		}
+		_map_size = st.st_size;
+		_map = mmap(0, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (_map == MAP_FAILED) {
+			_map = nullptr;
+			throw EXCEPTION("Fail to mmap the file `%s'", filename.c_str());
+		}
+
+		_data = static_cast<uint8_t const *>(_map);
+		_size = _map_size;
+		try {
+			_check();
+		} catch (...) {
+			munmap(_map, _map_size);
+			throw;
+		}
+	}
+
+	metadata_index(metadata_index const &) = delete;
+	metadata_index & operator=(metadata_index const &) = delete;
+
+	~metadata_index()
+	{
+		if (_map)
+			munmap(_map, _map_size);
+	}
+
+	// true if the index was built from a file with this size and modification time.
+	bool is_up_to_date(uint64_t file_size, struct timespec const & mtime) const
+	{
+		return _header->file_size == file_size
+				and _header->mtime_sec == mtime.tv_sec
+				and _header->mtime_nsec == mtime.tv_nsec;
+	}
+
+	uint64_t root() const
+	{
+		return _header->root;
+	}
+
+	uint64_t object_count() const
+	{
+		return _header->objects.count;
+	}
+
+	// return the object at address, nullptr if the object is not indexed.
+	index_object_t const * find_object(uint64_t address) const
+	{
+		auto first = _table<index_object_t>(_header->objects);
+		auto last = first+_header->objects.count;
+		auto x = std::lower_bound(first, last, address, [](index_object_t const & a, uint64_t address) { return a.address < address; });
+		if (x == last or x->address != address)
+			return nullptr;
+		return x;
+	}
+
+	void decode_metadata(index_object_t const & x, object_metadata_t & metadata) const
+	{
+		index_decode_metadata(_data+_header->metadata.offset+x.metadata, x.metadata_size, metadata);
+	}
+
+	// return the address of the object linked with name, undef if not found or not a hard link.
+	max_offset_type find_link(index_object_t const & x, string const & name) const
+	{
+		auto links = _table<index_link_t>(_header->links)+x.first_link;
+		auto order = _table<uint32_t>(_header->link_order)+x.first_link;
+		auto last = order+x.link_count;
+		auto i = std::lower_bound(order, last, name, [&](uint32_t i, string const & name) {
+			return _compare(_string(links[i].name), links[i].name_size, name.data(), name.size()) < 0;
+		});
+		if (i == last or _compare(_string(links[*i].name), links[*i].name_size, name.data(), name.size()) != 0)
+			return undef_max_offset;
+		return links[*i].address;
+	}
+
+	void keys(index_object_t const & x, vector<string> & ret) const
+	{
+		auto links = _table<index_link_t>(_header->links)+x.first_link;
+		for (uint64_t i = 0; i < x.link_count; ++i)
+			ret.emplace_back(_string(links[i].name), links[i].name_size);
+	}
+
+	void list_links(index_object_t const & x, vector<object_link_t> & ret) const
+	{
+		auto links = _table<index_link_t>(_header->links)+x.first_link;
+		for (uint64_t i = 0; i < x.link_count; ++i) {
+			ret.push_back(object_link_t{static_cast<uint8_t>(links[i].type),
+				string{_string(links[i].name), links[i].name_size}, links[i].address, string{}});
+		}
+	}
+
+	// lookup a path relative to the root group, components must be separated by a single '/'.
+	bool find_path(string const & path, uint64_t & address) const
+	{
+		auto first = _table<index_path_t>(_header->paths);
+		auto last = first+_header->paths.count;
+		auto x = std::lower_bound(first, last, path, [this](index_path_t const & a, string const & path) {
+			return _compare(_string(a.name), a.name_size, path.data(), path.size()) < 0;
+		});
+		if (x == last or _compare(_string(x->name), x->name_size, path.data(), path.size()) != 0)
+			return false;
+		address = x->address;
+		return true;
+	}
+
+	// chunks of a dataset sorted by linear index, only valid if HAS_CHUNKS is set.
+	chunk_entry_t const * chunks(index_object_t const & x) const
+	{
+		return _table<chunk_entry_t>(_header->chunks)+x.first_chunk;
+	}
+
+	/**
+	 * Write the index, the index is written to a temporary file that is
+	 * renamed, thus concurrent readers never see a partial index.
+	 **/
+	void write(string const & filename) const
+	{
+		string tmp = filename + ".tmp." + std::to_string(getpid());
+		int fd = open(tmp.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		if (fd < 0)
+			throw EXCEPTION("Fail to create file `%s'", tmp.c_str());
+
+		uint64_t offset = 0;
+		while (offset < _size) {
+			ssize_t n = ::write(fd, _data+offset, _size-offset);
+			if (n < 0 and errno == EINTR)
+				continue;
+			if (n <= 0) {
+				close(fd);
+				unlink(tmp.c_str());
+				throw EXCEPTION("Fail to write file `%s'", tmp.c_str());
+			}
+			offset += n;
+		}
+
+		if (close(fd) < 0 or rename(tmp.c_str(), filename.c_str()) < 0) {
+			unlink(tmp.c_str());
+			throw EXCEPTION("Fail to write file `%s'", filename.c_str());
+		}
+	}
+
+};
+
+/**
+ * Collect objects and serialize them to an index. Objects can be added in
+ * any order, each address must be added once.
+ **/
+class metadata_index_builder {
+public:
+
+	struct object_t {
+		uint64_t address;
+		string path;                   //< path from the root group, empty for the root group
+		object_metadata_t metadata;
+		vector<object_link_t> links;
+		bool has_chunks = false;
+		vector<chunk_entry_t> chunks;
+	};
+
+private:
+	vector<object_t> _objects;
+
+	template<typename T>
+	static void _append_table(vector<uint8_t> & out, index_table_t & table, T const * data, uint64_t count, uint64_t size)
+	{
+		out.resize((out.size()+7)&~7ul, 0);
+		table.offset = out.size();
+		table.count = count;
+		auto p = reinterpret_cast<uint8_t const *>(data);
+		out.insert(out.end(), p, p+size);
+	}
+
+public:
+
+	void add(object_t && x)
+	{
+		_objects.push_back(std::move(x));
+	}
+
+	vector<uint8_t> serialize(uint64_t root, uint64_t file_size, struct timespec const & mtime)
+	{
+		std::sort(_objects.begin(), _objects.end(), [](object_t const & a, object_t const & b) { return a.address < b.address; });
+
+		vector<index_object_t> objects;
+		vector<index_link_t> links;
+		vector<uint32_t> link_order;
+		vector<index_path_t> paths;
+		vector<chunk_entry_t> chunks;
+		vector<uint8_t> metadata;
+		string strings;
+
+		objects.reserve(_objects.size());
+		for (auto const & x: _objects) {
+			index_object_t o;
+			memset(&o, 0, sizeof(o));
+			o.address = x.address;
+			o.metadata = metadata.size();
+			index_encode_metadata(metadata, x.metadata);
+			o.metadata_size = metadata.size()-o.metadata;
+
+			o.first_link = links.size();
+			o.link_count = x.links.size();
+			for (auto const & link: x.links) {
+				links.push_back(index_link_t{link.offset, strings.size(), static_cast<uint32_t>(link.name.size()), link.type});
+				strings += link.name;
+			}
+			for (uint32_t i = 0; i < x.links.size(); ++i)
+				link_order.push_back(i);
+			std::sort(link_order.begin()+o.first_link, link_order.end(), [&x](uint32_t a, uint32_t b) {
+				return x.links[a].name < x.links[b].name;
+			});
+
+			if (x.has_chunks) {
+				o.flags |= index_object_t::HAS_CHUNKS;
+				o.first_chunk = chunks.size();
+				o.chunk_count = x.chunks.size();
+				chunks.insert(chunks.end(), x.chunks.begin(), x.chunks.end());
+			}
+
+			if (not x.path.empty()) {
+				paths.push_back(index_path_t{strings.size(), x.path.size(), x.address});
+				strings += x.path;
+			}
+
+			objects.push_back(o);
+		}
+
+		std::sort(paths.begin(), paths.end(), [&strings](index_path_t const & a, index_path_t const & b) {
+			return strings.compare(a.name, a.name_size, strings, b.name, b.name_size) < 0;
+		});
+
+		index_header_t header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+		header.version = INDEX_VERSION;
+		header.header_size = sizeof(index_header_t);
+		header.byte_order = INDEX_BYTE_ORDER;
+		header.file_size = file_size;
+		header.mtime_sec = mtime.tv_sec;
+		header.mtime_nsec = mtime.tv_nsec;
+		header.root = root;
+
+		vector<uint8_t> out(sizeof(index_header_t));
+		_append_table(out, header.objects, objects.data(), objects.size(), objects.size()*sizeof(index_object_t));
+		_append_table(out, header.links, links.data(), links.size(), links.size()*sizeof(index_link_t));
+		_append_table(out, header.chunks, chunks.data(), chunks.size(), chunks.size()*sizeof(chunk_entry_t));
+		_append_table(out, header.paths, paths.data(), paths.size(), paths.size()*sizeof(index_path_t));
+		_append_table(out, header.link_order, link_order.data(), link_order.size(), link_order.size()*sizeof(uint32_t));
+		_append_table(out, header.metadata, metadata.data(), metadata.size(), metadata.size());
+		_append_table(out, header.strings, strings.data(), strings.size(), strings.size());
+		header.size = out.size();
+		memcpy(out.data(), &header, sizeof(header));
+		return out;
+	}
+
+};
+
+} // h5ng
+
+#endif /* SRC_H5NG_INDEX_HXX_ */
@@ -0,0 +1,86 @@
+/*
+ * h5ng-object-cache.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_OBJECT_CACHE_HXX_
+#define SRC_H5NG_OBJECT_CACHE_HXX_
+
+#include <cstdint>
+#include <array>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace h5ng {
+
+using namespace std;
+
+/**
+ * Cache of loaded objects, safe to use from many threads.
+ *
+ * Keys are spread over independent shards, each with its own lock, thus
+ * concurrent readers rarely wait on each other. Objects are created without
+ * lock held, if two threads load the same object at the same time the first
+ * inserted is kept and returned to both.
+ **/
+template<typename K, typename V, typename H = std::hash<K>>
+class object_cache {
+
+	enum : size_t { SHARD_COUNT = 16 };
+
+	// aligned to avoid false sharing between the locks of adjacent shards.
+	struct alignas(64) shard {
+		mutex lock;
+		unordered_map<K, shared_ptr<V>, H> objects;
+	};
+
+	array<shard, SHARD_COUNT> _shards;
+
+	shard & _get_shard(K const & key)
+	{
+		// mix the hash, offsets of objects are often aligned.
+		uint64_t h = H{}(key)*0x9e3779b97f4a7c15ul;
+		return _shards[(h >> 32)%SHARD_COUNT];
+	}
+
+public:
+
+	object_cache() = default;
+	object_cache(object_cache const &) = delete;
+	object_cache & operator=(object_cache const &) = delete;
+
+	// return the object or null if not in the cache.
+	shared_ptr<V> find(K const & key)
+	{
+		auto & s = _get_shard(key);
+		unique_lock<mutex> l{s.lock};
+		auto x = s.objects.find(key);
+		if (x == s.objects.end())
+			return nullptr;
+		return x->second;
+	}
+
+	// return the object, create it with make() if it is not in the cache.
+	template<typename F>
+	shared_ptr<V> get(K const & key, F && make)
+	{
+		auto ret = find(key);
+		if (ret)
+			return ret;
+
+		shared_ptr<V> obj = make();
+
+		auto & s = _get_shard(key);
+		unique_lock<mutex> l{s.lock};
+		return s.objects.emplace(key, obj).first->second;
+	}
+
+};
+
+} // h5ng
+
+#endif /* SRC_H5NG_OBJECT_CACHE_HXX_ */
@@ -255,6 +255,113 @@ struct b_tree_v2_node_spec : public type_spec {
 	enum : uint64_t { size = last<type>::size };
 } __attribute__((packed));
 
+// Layout: Fractal Heap Header
+struct fractal_heap_hdr_spec : public type_spec {
+	using signature                          = spec<uint8_t[4],   none>;
+	using version                            = spec<uint8_t,      signature>;
+	using heap_id_length                     = spec<uint16_t,     version>;
+	using io_filters_encoded_length          = spec<uint16_t,     heap_id_length>;
+	using flags                              = spec<uint8_t,      io_filters_encoded_length>;
+	using maximum_size_of_managed_objects    = spec<uint32_t,     flags>;
+	using next_huge_object_id                = spec<length_type,  maximum_size_of_managed_objects>;
+	using huge_objects_btree_address         = spec<offset_type,  next_huge_object_id>;
+	using amount_of_free_space               = spec<length_type,  huge_objects_btree_address>;
+	using free_space_manager_address         = spec<offset_type,  amount_of_free_space>;
+	using amount_of_managed_space            = spec<length_type,  free_space_manager_address>;
+	using amount_of_allocated_managed_space  = spec<length_type,  amount_of_managed_space>;
+	using direct_block_allocation_iterator   = spec<length_type,  amount_of_allocated_managed_space>;
+	using number_of_managed_objects          = spec<length_type,  direct_block_allocation_iterator>;
+	using size_of_huge_objects               = spec<length_type,  number_of_managed_objects>;
+	using number_of_huge_objects             = spec<length_type,  size_of_huge_objects>;
+	using size_of_tiny_objects               = spec<length_type,  number_of_huge_objects>;
+	using number_of_tiny_objects             = spec<length_type,  size_of_tiny_objects>;
+	using table_width                        = spec<uint16_t,     number_of_tiny_objects>;
+	using starting_block_size                = spec<length_type,  table_width>;
+	using maximum_direct_block_size          = spec<length_type,  starting_block_size>;
+	using maximum_heap_size                  = spec<uint16_t,     maximum_direct_block_size>;
+	using starting_number_of_rows            = spec<uint16_t,     maximum_heap_size>;
+	using root_block_address                 = spec<offset_type,  starting_number_of_rows>;
+	using current_number_of_rows             = spec<uint16_t,     root_block_address>;
+
+	// variable size: filtered root direct block info if filtered, then checksum
+	enum : uint64_t { size = last<current_number_of_rows>::size };
+
+};
+
+// Layout: Fractal Heap Direct Block and Indirect Block
+struct fractal_heap_block_spec : public type_spec {
+	using signature                     = spec<uint8_t[4],   none>;
+	using version                       = spec<uint8_t,      signature>;
+	using heap_header_address           = spec<offset_type,  version>;
+
+	// variable size: block offset then block content
+	enum : uint64_t { size = last<heap_header_address>::size };
+
+};
+
+// Layout: Fixed Array Header
+struct fixed_array_hdr_spec : public type_spec {
+	using signature                     = spec<uint8_t[4],   none>;
+	using version                       = spec<uint8_t,      signature>;
+	using client_id                     = spec<uint8_t,      version>;
+	using entry_size                    = spec<uint8_t,      client_id>;
+	using page_bits                     = spec<uint8_t,      entry_size>;
+	using max_num_entries               = spec<length_type,  page_bits>;
+	using data_block_address            = spec<offset_type,  max_num_entries>;
+	using checksum                      = spec<uint32_t,     data_block_address>;
+
+	enum : uint64_t { size = last<checksum>::size };
+
+};
+
+// Layout: Fixed Array Data Block
+struct fixed_array_data_block_spec : public type_spec {
+	using signature                     = spec<uint8_t[4],   none>;
+	using version                       = spec<uint8_t,      signature>;
+	using client_id                     = spec<uint8_t,      version>;
+	using header_address                = spec<offset_type,  client_id>;
+
+	// variable size: page bitmap, elements, checksum then pages
+	enum : uint64_t { size = last<header_address>::size };
+
+};
+
+// Layout: Extensible Array Header
+struct extensible_array_hdr_spec : public type_spec {
+	using signature                     = spec<uint8_t[4],   none>;
+	using version                       = spec<uint8_t,      signature>;
+	using client_id                     = spec<uint8_t,      version>;
+	using element_size                  = spec<uint8_t,      client_id>;
+	using max_nelmts_bits               = spec<uint8_t,      element_size>;
+	using index_block_elements          = spec<uint8_t,      max_nelmts_bits>;
+	using data_block_min_elements       = spec<uint8_t,      index_block_elements>;
+	using secondary_block_min_data_ptrs = spec<uint8_t,      data_block_min_elements>;
+	using max_dblk_page_nelmts_bits     = spec<uint8_t,      secondary_block_min_data_ptrs>;
+	using number_of_secondary_blocks    = spec<length_type,  max_dblk_page_nelmts_bits>;
+	using size_of_secondary_blocks      = spec<length_type,  number_of_secondary_blocks>;
+	using number_of_data_blocks         = spec<length_type,  size_of_secondary_blocks>;
+	using size_of_data_blocks           = spec<length_type,  number_of_data_blocks>;
+	using max_index_set                 = spec<length_type,  size_of_data_blocks>;
+	using number_of_elements            = spec<length_type,  max_index_set>;
+	using index_block_address           = spec<offset_type,  number_of_elements>;
+	using checksum                      = spec<uint32_t,     index_block_address>;
+
+	enum : uint64_t { size = last<checksum>::size };
+
+};
+
+// Layout: Extensible Array Index Block, Secondary Block and Data Block
+struct extensible_array_block_spec : public type_spec {
+	using signature                     = spec<uint8_t[4],   none>;
+	using version                       = spec<uint8_t,      signature>;
+	using client_id                     = spec<uint8_t,      version>;
+	using header_address                = spec<offset_type,  client_id>;
+
+	// variable size: block offset (not in index block) then block content
+	enum : uint64_t { size = last<header_address>::size };
+
+};
+
 struct object_header_v1_spec : public type_spec {
 	using version                             = spec<uint8_t,  none>;
 	using reserved_0                          = spec<uint8_t,  version>;
@@ -0,0 +1,158 @@
+/*
+ * h5ng-stats.cxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ *
+ * Print statistics of datasets, datasets are reduced chunk by chunk and are
+ * never loaded in memory.
+ */
+
+#include <hdf5-ng.hxx>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+
+using namespace std;
+
+static void usage(char const * name)
+{
+	cerr << "usage: " << name << " [options] <file> <dataset> [<dataset> ...]" << endl;
+	cerr << "  -a, --axis N          also print statistics per index of axis N" << endl;
+	cerr << "  -b, --bins N          print an histogram of N bins" << endl;
+	cerr << "  -r, --range MIN MAX   histogram range, the data range by default" << endl;
+	cerr << "  -j, --threads N       number of threads, including the main thread" << endl;
+	cerr << "  -s, --serial          reduce chunks in the calling thread only" << endl;
+	cerr << "  --backend NAME        storage backend: mmap, pread or io_uring" << endl;
+}
+
+// parse an integer in [min, max], the whole string must be used.
+static bool parse_long(char const * value, long min, long max, long & ret)
+{
+	char * end;
+	errno = 0;
+	ret = strtol(value, &end, 10);
+	return end != value and *end == '\0' and errno == 0 and ret >= min and ret <= max;
+}
+
+// parse a floating-point number, the whole string must be used.
+static bool parse_double(char const * value, double & ret)
+{
+	char * end;
+	errno = 0;
+	ret = strtod(value, &end);
+	return end != value and *end == '\0' and errno == 0;
+}
+
+static void print_accumulator(h5ng::stats_accumulator_t const & x)
+{
+	cout << "count=" << x.count
+		 << " nan=" << x.nan_count
+		 << " min=" << x.min
+		 << " max=" << x.max
+		 << " sum=" << x.sum
+		 << " mean=" << (x.count > 0 ? x.mean : NAN)
+		 << " variance=" << x.variance()
+		 << " stddev=" << std::sqrt(x.variance());
+}
+
+static void print_histogram(h5ng::dataset_stats_t const & stats, h5ng::stats_accumulator_t const & x, char const * indent)
+{
+	auto n = x.histogram.size();
+	double width = (stats.range_max-stats.range_min)/n;
+	for (size_t i = 0; i < n; ++i) {
+		cout << indent << "[" << stats.range_min+i*width << ", " << stats.range_min+(i+1)*width
+			 << (i+1 == n ? "]" : ")") << " " << x.histogram[i] << endl;
+	}
+}
+
+int main(int argc, char const ** argv) {
+	h5ng::stats_options_t options;
+	h5ng::storage_backend_e backend = h5ng::STORAGE_MMAP;
+
+	int i = 1;
+	for (; i < argc and argv[i][0] == '-'; ++i) {
+		string opt = argv[i];
+		bool has_arg = i+1 < argc;
+		long value;
+		bool valid = true;
+		if ((opt == "-a" or opt == "--axis") and has_arg) {
+			valid = parse_long(argv[++i], 0, INT_MAX, value);
+			options.axis = value;
+		} else if ((opt == "-b" or opt == "--bins") and has_arg) {
+			valid = parse_long(argv[++i], 1, UINT32_MAX, value);
+			options.bins = value;
+		} else if ((opt == "-r" or opt == "--range") and i+2 < argc) {
+			valid = parse_double(argv[i+1], options.range_min) and parse_double(argv[i+2], options.range_max);
+			i += 2;
+		} else if ((opt == "-j" or opt == "--threads") and has_arg) {
+			valid = parse_long(argv[++i], 1, UINT_MAX, value);
+			if (valid)
+				h5ng::set_thread_count(value);
+		} else if (opt == "-s" or opt == "--serial") {
+			options.parallel = false;
+		} else if (opt == "--backend" and has_arg) {
+			string name = argv[++i];
+			if (name == "mmap") {
+				backend = h5ng::STORAGE_MMAP;
+			} else if (name == "pread") {
+				backend = h5ng::STORAGE_PREAD;
+			} else if (name == "io_uring") {
+				backend = h5ng::STORAGE_IO_URING;
+			} else {
+				usage(argv[0]);
+				return 1;
+			}
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+
+		if (not valid) {
+			cerr << "invalid value for option " << opt << endl;
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (argc-i < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		h5ng::h5obj f(argv[i], backend);
+		for (++i; i < argc; ++i) {
+			auto d = f[argv[i]];
+			auto stats = d.stats(options);
+
+			cout << argv[i] << " shape=[";
+			auto shape = d.shape();
+			for (size_t k = 0; k < shape.size(); ++k)
+				cout << (k > 0 ? ", " : "") << shape[k];
+			cout << "] ";
+			print_accumulator(stats.total);
+			cout << endl;
+
+			if (options.bins > 0)
+				print_histogram(stats, stats.total, "  ");
+
+			for (size_t k = 0; k < stats.per_axis.size(); ++k) {
+				cout << "  axis " << stats.axis << " index " << k << " ";
+				print_accumulator(stats.per_axis[k]);
+				cout << endl;
+				if (options.bins > 0)
+					print_histogram(stats, stats.per_axis[k], "    ");
+			}
+		}
+	} catch (std::exception & e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * h5ng-stats.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_STATS_HXX_
+#define SRC_H5NG_STATS_HXX_
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "h5ng.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+// Fixed bins over [min, max], the last bin include max.
+struct stats_bins_t {
+	uint32_t count;
+	double min;
+	double max;
+	double scale;
+
+	stats_bins_t() : count{0}, min{0.0}, max{0.0}, scale{0.0} { }
+
+	stats_bins_t(uint32_t count, double min, double max) :
+		count{count}, min{min}, max{max}, scale{max > min ? count/(max-min) : 0.0}
+	{
+
+	}
+
+	void add(vector<uint64_t> & histogram, double x, uint64_t n = 1) const
+	{
+		if (not (x >= min and x <= max)) // out of range or NaN
+			return;
+		uint64_t i = static_cast<uint64_t>((x-min)*scale);
+		histogram[std::min<uint64_t>(i, count-1)] += n;
+	}
+
+	/**
+	 * Add n contiguous values. Bin indices of values are computed four at
+	 * a time and clamped to the bins before the truncation, thus they match
+	 * add(). Values out of range or NaN are added as 0, without branch.
+	 **/
+	void add_run(vector<uint64_t> & histogram, double const * x, uint64_t n) const
+	{
+		uint64_t i = 0;
+
+#ifdef __SSE2__
+		if (count <= INT32_MAX) { // indices are converted to 32 bits
+			__m128d vmin = _mm_set1_pd(min);
+			__m128d vmax = _mm_set1_pd(max);
+			__m128d vscale = _mm_set1_pd(scale);
+			__m128d vlast = _mm_set1_pd(count-1);
+			__m128d zero = _mm_setzero_pd();
+			int32_t index[4];
+			for (; i+4 <= n; i += 4) {
+				__m128d a = _mm_loadu_pd(x+i);
+				__m128d b = _mm_loadu_pd(x+i+2);
+				// ordered compares are false for NaN.
+				unsigned mask = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(a, vmin), _mm_cmple_pd(a, vmax)))
+						| _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(b, vmin), _mm_cmple_pd(b, vmax))) << 2;
+				// max and min return the second operand if the first is NaN.
+				__m128d fa = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(a, vmin), vscale), zero), vlast);
+				__m128d fb = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(b, vmin), vscale), zero), vlast);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(index), _mm_unpacklo_epi64(_mm_cvttpd_epi32(fa), _mm_cvttpd_epi32(fb)));
+				histogram[index[0]] += mask & 1u;
+				histogram[index[1]] += (mask >> 1) & 1u;
+				histogram[index[2]] += (mask >> 2) & 1u;
+				histogram[index[3]] += (mask >> 3) & 1u;
+			}
+		}
+#endif
+
+		for (; i < n; ++i)
+			add(histogram, x[i]);
+	}
+
+};
+
+// Add n times the value x.
+static inline void stats_add_repeated(stats_accumulator_t & acc, stats_bins_t const & bins, double x, uint64_t n)
+{
+	if (n == 0)
+		return;
+
+	if (bins.count > 0) {
+		acc.histogram.resize(bins.count, 0);
+		bins.add(acc.histogram, x, n);
+	}
+
+	if (std::isnan(x)) {
+		acc.nan_count += n;
+		return;
+	}
+
+	stats_accumulator_t r;
+	r.count = n;
+	r.min = x;
+	r.max = x;
+	r.sum = x*n;
+	r.mean = x;
+	acc.merge(r);
+}
+
+/**
+ * Sum, min, max and count of values that are not NaN, NaN are masked out
+ * with an ordered compare and ignored by min and max.
+ **/
+static inline void _stats_reduce_sum(double const * x, uint64_t n, uint64_t & count, double & sum, double & min, double & max)
+{
+	uint64_t i = 0;
+	uint64_t c = 0;
+	double s = 0.0;
+	double lo = numeric_limits<double>::infinity();
+	double hi = -numeric_limits<double>::infinity();
+
+#ifdef __SSE2__
+	__m128d vs0 = _mm_setzero_pd(), vs1 = _mm_setzero_pd();
+	__m128d vlo0 = _mm_set1_pd(lo), vlo1 = vlo0;
+	__m128d vhi0 = _mm_set1_pd(hi), vhi1 = vhi0;
+	for (; i+4 <= n; i += 4) {
+		__m128d a = _mm_loadu_pd(x+i);
+		__m128d b = _mm_loadu_pd(x+i+2);
+		__m128d ma = _mm_cmpord_pd(a, a);
+		__m128d mb = _mm_cmpord_pd(b, b);
+		vs0 = _mm_add_pd(vs0, _mm_and_pd(a, ma));
+		vs1 = _mm_add_pd(vs1, _mm_and_pd(b, mb));
+		// min and max return the second operand if the first is NaN.
+		vlo0 = _mm_min_pd(a, vlo0);
+		vlo1 = _mm_min_pd(b, vlo1);
+		vhi0 = _mm_max_pd(a, vhi0);
+		vhi1 = _mm_max_pd(b, vhi1);
+		c += __builtin_popcount(_mm_movemask_pd(ma)) + __builtin_popcount(_mm_movemask_pd(mb));
+	}
+
+	double tmp[2];
+	_mm_storeu_pd(tmp, _mm_add_pd(vs0, vs1));
+	s = tmp[0]+tmp[1];
+	_mm_storeu_pd(tmp, _mm_min_pd(vlo0, vlo1));
+	lo = std::min(tmp[0], tmp[1]);
+	_mm_storeu_pd(tmp, _mm_max_pd(vhi0, vhi1));
+	hi = std::max(tmp[0], tmp[1]);
+#endif
+
+	for (; i < n; ++i) {
+		if (std::isnan(x[i]))
+			continue;
+		++c;
+		s += x[i];
+		lo = std::min(lo, x[i]);
+		hi = std::max(hi, x[i]);
+	}
+
+	count = c;
+	sum = s;
+	min = lo;
+	max = hi;
+}
+
+// Sum of squared differences to mean of values that are not NaN.
+static inline double _stats_reduce_m2(double const * x, uint64_t n, double mean)
+{
+	uint64_t i = 0;
+	double m2 = 0.0;
+
+#ifdef __SSE2__
+	__m128d vm = _mm_set1_pd(mean);
+	__m128d v0 = _mm_setzero_pd(), v1 = _mm_setzero_pd();
+	for (; i+4 <= n; i += 4) {
+		__m128d a = _mm_loadu_pd(x+i);
+		__m128d b = _mm_loadu_pd(x+i+2);
+		__m128d da = _mm_and_pd(_mm_sub_pd(a, vm), _mm_cmpord_pd(a, a));
+		__m128d db = _mm_and_pd(_mm_sub_pd(b, vm), _mm_cmpord_pd(b, b));
+		v0 = _mm_add_pd(v0, _mm_mul_pd(da, da));
+		v1 = _mm_add_pd(v1, _mm_mul_pd(db, db));
+	}
+
+	double tmp[2];
+	_mm_storeu_pd(tmp, _mm_add_pd(v0, v1));
+	m2 = tmp[0]+tmp[1];
+#endif
+
+	for (; i < n; ++i) {
+		if (std::isnan(x[i]))
+			continue;
+		double d = x[i]-mean;
+		m2 += d*d;
+	}
+
+	return m2;
+}
+
+/**
+ * Reduce n contiguous values into acc. The run is reduced in two passes,
+ * the second compute the squared differences to the mean of the run, then
+ * the run is merged into acc. Runs should be small enough to stay in cache.
+ **/
+static inline void stats_reduce(stats_accumulator_t & acc, stats_bins_t const & bins, double const * x, uint64_t n)
+{
+	if (n == 0)
+		return;
+
+	if (bins.count > 0) {
+		acc.histogram.resize(bins.count, 0);
+		bins.add_run(acc.histogram, x, n);
+	}
+
+	stats_accumulator_t r;
+	_stats_reduce_sum(x, n, r.count, r.sum, r.min, r.max);
+	acc.nan_count += n-r.count;
+	if (r.count == 0)
+		return;
+	r.mean = r.sum/r.count;
+	r.m2 = _stats_reduce_m2(x, n, r.mean);
+	acc.merge(r);
+}
+
+} // h5ng
+
+#endif /* SRC_H5NG_STATS_HXX_ */
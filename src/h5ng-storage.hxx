@@ -0,0 +1,652 @@
+/*
+ * h5ng-storage.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_STORAGE_HXX_
+#define SRC_H5NG_STORAGE_HXX_
+
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sched.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "h5ng.hxx"
+#include "h5ng-thread-pool.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+// A range of bytes within the file.
+struct storage_extent_t {
+	uint64_t offset;
+	uint64_t size;
+};
+
+/**
+ * Access to the bytes of a file.
+ *
+ * The whole file is always mapped, metadata are read through the mapping.
+ * Raw data of planned reads are requested with fetch(), the default
+ * implementation use the mapping and only prefetch the extents, derived
+ * backends read them explicitly.
+ **/
+class file_storage {
+protected:
+	int _fd;
+	uint8_t * _data;
+	uint64_t _size;
+	struct timespec _mtime;
+
+public:
+
+	// gap allowed between two extents read at once, and maximum size of one read.
+	enum : uint64_t {
+		PAGE_SIZE = 1ul<<12,
+		MERGE_GAP = 1ul<<16,
+		MAX_RUN_SIZE = 1ul<<24
+	};
+
+	// extents that are read together, first and last index the sorted extents.
+	struct run_t {
+		uint64_t offset;
+		uint64_t size;
+		size_t first;
+		size_t last;
+	};
+
+	explicit file_storage(string const & filename)
+	{
+		_fd = open(filename.c_str(), O_RDONLY);
+		if (_fd < 0)
+			throw EXCEPTION("Fail to open file `%s'", filename.c_str());
+		struct stat st;
+		if (fstat(_fd, &st) < 0) {
+			close(_fd);
+			throw EXCEPTION("Fail to stat file `%s'", filename.c_str());
+		}
+		_size = st.st_size;
+		_mtime = st.st_mtim;
+		_data = static_cast<uint8_t*>(mmap(0, _size, PROT_READ, MAP_SHARED, _fd, 0));
+		if (_data == MAP_FAILED) {
+			close(_fd);
+			throw EXCEPTION("Fail to mmap the file `%s'", filename.c_str());
+		}
+	}
+
+	file_storage(file_storage const &) = delete;
+	file_storage & operator=(file_storage const &) = delete;
+
+	virtual ~file_storage()
+	{
+		munmap(_data, _size);
+		close(_fd);
+	}
+
+	uint8_t * data() const
+	{
+		return _data;
+	}
+
+	uint64_t size() const
+	{
+		return _size;
+	}
+
+	// modification time of the file when it was opened.
+	struct timespec mtime() const
+	{
+		return _mtime;
+	}
+
+	virtual auto backend() const -> storage_backend_e
+	{
+		return STORAGE_MMAP;
+	}
+
+	/**
+	 * Sort extents by file offset and group them in runs, extents closer
+	 * than MERGE_GAP are merged up to MAX_RUN_SIZE. Run bounds are aligned
+	 * to pages. order is the sorted list of extent index.
+	 **/
+	void plan_runs(vector<storage_extent_t> const & extents, vector<size_t> & order, vector<run_t> & runs) const
+	{
+		order.resize(extents.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&extents](size_t a, size_t b) {
+			return extents[a].offset < extents[b].offset;
+		});
+
+		runs.clear();
+		for (size_t i = 0; i < order.size(); ++i) {
+			auto const & e = extents[order[i]];
+			uint64_t bgn = e.offset & ~(PAGE_SIZE-1);
+			uint64_t end = std::min(_size, (e.offset + e.size + PAGE_SIZE - 1) & ~(PAGE_SIZE-1));
+			if (not runs.empty()) {
+				auto & r = runs.back();
+				uint64_t r_end = r.offset + r.size;
+				if (bgn <= r_end + MERGE_GAP and std::max(end, r_end) - r.offset <= MAX_RUN_SIZE) {
+					r.size = std::max(end, r_end) - r.offset;
+					r.last = i+1;
+					continue;
+				}
+			}
+			runs.push_back(run_t{bgn, end-bgn, i, i+1});
+		}
+	}
+
+	// hint the kernel that extents will be read soon.
+	void prefetch(vector<storage_extent_t> const & extents) const
+	{
+		vector<size_t> order;
+		vector<run_t> runs;
+		plan_runs(extents, order, runs);
+		for (auto const & r: runs) {
+			madvise(_data + r.offset, r.size, MADV_WILLNEED);
+		}
+	}
+
+	/**
+	 * Call func(i, data) once for each extent, data point to the extent
+	 * bytes and is valid only during the call. If parallel is true, calls
+	 * are made concurrently by the default thread pool. The first exception
+	 * thrown by func is rethrown.
+	 **/
+	virtual void fetch(vector<storage_extent_t> const & extents, bool parallel, function<void(size_t, uint8_t const *)> const & func)
+	{
+		prefetch(extents);
+		auto call = [&](size_t i) {
+			func(i, _data + extents[i].offset);
+		};
+
+		if (parallel) {
+			default_thread_pool()->parallel_for(extents.size(), call);
+		} else {
+			for (size_t i = 0; i < extents.size(); ++i)
+				call(i);
+		}
+	}
+
+};
+
+/**
+ * Pool of page aligned buffers, kept for reuse between reads.
+ **/
+class aligned_buffer_pool {
+	struct _free {
+		void operator()(uint8_t * p) const { std::free(p); }
+	};
+
+public:
+	using buffer = unique_ptr<uint8_t, _free>;
+
+private:
+	enum : size_t { MAX_FREE_BUFFERS = 64 };
+
+	mutex _lock;
+	vector<pair<buffer, uint64_t>> _buffers; //< free buffers and their capacity
+
+public:
+
+	// return a buffer of at least size bytes, capacity is set to the actual size.
+	buffer acquire(uint64_t size, uint64_t & capacity)
+	{
+		{
+			unique_lock<mutex> l{_lock};
+			for (auto & x: _buffers) {
+				if (x.second >= size) {
+					std::swap(x, _buffers.back());
+					auto ret = std::move(_buffers.back());
+					_buffers.pop_back();
+					capacity = ret.second;
+					return std::move(ret.first);
+				}
+			}
+		}
+
+		capacity = std::max<uint64_t>(size, file_storage::PAGE_SIZE);
+		void * p = nullptr;
+		if (posix_memalign(&p, file_storage::PAGE_SIZE, capacity) != 0)
+			throw EXCEPTION("Fail to allocate read buffer of %lu bytes", capacity);
+		return buffer{static_cast<uint8_t*>(p)};
+	}
+
+	void release(buffer b, uint64_t capacity)
+	{
+		unique_lock<mutex> l{_lock};
+		if (_buffers.size() < MAX_FREE_BUFFERS)
+			_buffers.emplace_back(std::move(b), capacity);
+	}
+
+};
+
+/**
+ * Read extents with pread, runs are read by the default thread pool, each
+ * thread read one run into an aligned buffer and process its extents.
+ **/
+class pread_storage : public file_storage {
+protected:
+	aligned_buffer_pool _pool;
+
+	// read exactly size bytes at offset.
+	void _read(uint8_t * buffer, uint64_t offset, uint64_t size) const
+	{
+		while (size > 0) {
+			ssize_t n = pread(_fd, buffer, size, offset);
+			if (n < 0 and errno == EINTR)
+				continue;
+			if (n <= 0)
+				throw EXCEPTION("Fail to read %lu bytes at offset %lu", size, offset);
+			buffer += n;
+			offset += n;
+			size -= n;
+		}
+	}
+
+	// process extents of a run that have been read into buffer.
+	static void _dispatch(run_t const & r, uint8_t const * buffer, vector<storage_extent_t> const & extents,
+			vector<size_t> const & order, function<void(size_t, uint8_t const *)> const & func)
+	{
+		for (size_t k = r.first; k < r.last; ++k) {
+			size_t i = order[k];
+			func(i, buffer + (extents[i].offset - r.offset));
+		}
+	}
+
+public:
+
+	explicit pread_storage(string const & filename) : file_storage{filename} { }
+
+	virtual auto backend() const -> storage_backend_e override
+	{
+		return STORAGE_PREAD;
+	}
+
+	virtual void fetch(vector<storage_extent_t> const & extents, bool parallel, function<void(size_t, uint8_t const *)> const & func) override
+	{
+		vector<size_t> order;
+		vector<run_t> runs;
+		plan_runs(extents, order, runs);
+
+		auto read_run = [&](size_t k) {
+			auto const & r = runs[k];
+			uint64_t capacity;
+			auto buffer = _pool.acquire(r.size, capacity);
+			_read(buffer.get(), r.offset, r.size);
+			_dispatch(r, buffer.get(), extents, order, func);
+			_pool.release(std::move(buffer), capacity);
+		};
+
+		if (parallel) {
+			default_thread_pool()->parallel_for(runs.size(), read_run);
+		} else {
+			for (size_t k = 0; k < runs.size(); ++k)
+				read_run(k);
+		}
+	}
+
+};
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+/**
+ * Read extents with io_uring, runs are submitted in batches, the next batch
+ * is read by the kernel while the current one is processed. Concurrent
+ * fetch share the ring thus they are serialized. If the kernel does not
+ * provide io_uring, or once the ring failed with reads in flight, fetch fall
+ * back to pread.
+ **/
+class io_uring_storage : public pread_storage {
+
+	enum : unsigned { QUEUE_DEPTH = 32 };
+	enum : uint64_t { MAX_BATCH_SIZE = 1ul<<26 };
+
+	mutex _ring_lock;
+	int _ring_fd;
+	io_uring_params _params;
+	uint8_t * _sq_ring;
+	uint8_t * _cq_ring;
+	uint64_t _sq_ring_size;
+	uint64_t _cq_ring_size;
+	io_uring_sqe * _sqes;
+	unsigned _unsubmitted; //< queued sqe not yet given to the kernel
+	unsigned _in_flight; //< queued sqe without completion yet
+	bool _broken; //< the ring failed with reads in flight, fetch use pread
+	uint64_t _max_read; //< maximum size of one read request, 0 for no limit
+
+	// state of one run in flight.
+	struct _request {
+		aligned_buffer_pool::buffer buffer;
+		uint64_t capacity;
+		iovec iov;
+		uint64_t done; //< bytes read so far
+	};
+
+	template<typename T>
+	T * _sq(uint32_t off) const { return reinterpret_cast<T*>(_sq_ring + off); }
+
+	template<typename T>
+	T * _cq(uint32_t off) const { return reinterpret_cast<T*>(_cq_ring + off); }
+
+	void _setup()
+	{
+		std::memset(&_params, 0, sizeof(_params));
+		_ring_fd = syscall(__NR_io_uring_setup, 2*QUEUE_DEPTH, &_params);
+		if (_ring_fd < 0)
+			return;
+
+		_sq_ring_size = _params.sq_off.array + _params.sq_entries*sizeof(uint32_t);
+		_cq_ring_size = _params.cq_off.cqes + _params.cq_entries*sizeof(io_uring_cqe);
+		if (_params.features & IORING_FEAT_SINGLE_MMAP)
+			_sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+
+		void * sq = mmap(0, _sq_ring_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+		void * cq = sq;
+		if (sq != MAP_FAILED and not (_params.features & IORING_FEAT_SINGLE_MMAP))
+			cq = mmap(0, _cq_ring_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+		void * sqes = MAP_FAILED;
+		if (sq != MAP_FAILED and cq != MAP_FAILED)
+			sqes = mmap(0, _params.sq_entries*sizeof(io_uring_sqe), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+
+		if (sqes == MAP_FAILED) {
+			if (cq != MAP_FAILED and cq != sq)
+				munmap(cq, _cq_ring_size);
+			if (sq != MAP_FAILED)
+				munmap(sq, _sq_ring_size);
+			close(_ring_fd);
+			_ring_fd = -1;
+			return;
+		}
+
+		_sq_ring = static_cast<uint8_t*>(sq);
+		_cq_ring = static_cast<uint8_t*>(cq);
+		_sqes = static_cast<io_uring_sqe*>(sqes);
+	}
+
+	// queue a read of the remaining bytes of request k, submitted on next _enter.
+	void _queue(vector<run_t> const & runs, vector<_request> & requests, size_t k)
+	{
+		auto & q = requests[k];
+		q.iov.iov_base = q.buffer.get() + q.done;
+		q.iov.iov_len = runs[k].size - q.done;
+		if (_max_read > 0)
+			q.iov.iov_len = std::min<uint64_t>(q.iov.iov_len, _max_read);
+
+		uint32_t tail = *_sq<uint32_t>(_params.sq_off.tail);
+		uint32_t index = tail & *_sq<uint32_t>(_params.sq_off.ring_mask);
+		io_uring_sqe & sqe = _sqes[index];
+		std::memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_READV;
+		sqe.fd = _fd;
+		sqe.off = runs[k].offset + q.done;
+		sqe.addr = reinterpret_cast<uint64_t>(&q.iov);
+		sqe.len = 1;
+		sqe.user_data = k;
+		_sq<uint32_t>(_params.sq_off.array)[index] = index;
+		__atomic_store_n(_sq<uint32_t>(_params.sq_off.tail), tail+1, __ATOMIC_RELEASE);
+		++_unsubmitted;
+		++_in_flight;
+	}
+
+	/**
+	 * submit every queued sqe and wait for at least min_complete completions.
+	 * If the kernel is out of resources or the completion queue is full
+	 * (EAGAIN, EBUSY) it return, the caller reap completions and enter again.
+	 **/
+	void _enter(unsigned min_complete)
+	{
+		while (true) {
+			int ret = syscall(__NR_io_uring_enter, _ring_fd, _unsubmitted, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			if (ret >= 0) {
+				_unsubmitted -= std::min<unsigned>(ret, _unsubmitted);
+				return;
+			}
+			if (errno == EAGAIN or errno == EBUSY) {
+				sched_yield();
+				return;
+			}
+			if (errno != EINTR)
+				throw EXCEPTION("io_uring_enter failed (%d)", errno);
+		}
+	}
+
+	/**
+	 * drop sqe not yet given to the kernel and wait for completions of every
+	 * read in flight, their buffers can be released after. Return false if
+	 * the ring fail again, the kernel may then still write to the buffers.
+	 **/
+	bool _drain()
+	{
+		uint32_t sq_head = __atomic_load_n(_sq<uint32_t>(_params.sq_off.head), __ATOMIC_ACQUIRE);
+		uint32_t sq_tail = *_sq<uint32_t>(_params.sq_off.tail);
+		_in_flight -= std::min<unsigned>(sq_tail - sq_head, _in_flight);
+		_unsubmitted = 0;
+		__atomic_store_n(_sq<uint32_t>(_params.sq_off.tail), sq_head, __ATOMIC_RELEASE);
+
+		while (true) {
+			uint32_t head = *_cq<uint32_t>(_params.cq_off.head);
+			uint32_t tail = __atomic_load_n(_cq<uint32_t>(_params.cq_off.tail), __ATOMIC_ACQUIRE);
+			_in_flight -= std::min<unsigned>(tail - head, _in_flight);
+			__atomic_store_n(_cq<uint32_t>(_params.cq_off.head), tail, __ATOMIC_RELEASE);
+			if (_in_flight == 0)
+				return true;
+			int ret = syscall(__NR_io_uring_enter, _ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (ret < 0 and errno != EINTR and errno != EAGAIN and errno != EBUSY)
+				return false;
+		}
+	}
+
+	/**
+	 * handle available completions, short reads are queued again, completed
+	 * request are flagged in done.
+	 **/
+	void _reap(vector<run_t> const & runs, vector<_request> & requests, vector<char> & done, exception_ptr & error)
+	{
+		uint32_t head = *_cq<uint32_t>(_params.cq_off.head);
+		uint32_t mask = *_cq<uint32_t>(_params.cq_off.ring_mask);
+		while (head != __atomic_load_n(_cq<uint32_t>(_params.cq_off.tail), __ATOMIC_ACQUIRE)) {
+			io_uring_cqe const & cqe = _cq<io_uring_cqe>(_params.cq_off.cqes)[head & mask];
+			size_t k = cqe.user_data;
+			auto & q = requests[k];
+			--_in_flight;
+			if (cqe.res <= 0) {
+				if (not error)
+					error = make_exception_ptr(EXCEPTION("Fail to read %lu bytes at offset %lu (%d)", runs[k].size, runs[k].offset, -cqe.res));
+				done[k] = true;
+			} else {
+				q.done += cqe.res;
+				if (q.done < runs[k].size) {
+					_queue(runs, requests, k);
+				} else {
+					done[k] = true;
+				}
+			}
+			++head;
+		}
+		__atomic_store_n(_cq<uint32_t>(_params.cq_off.head), head, __ATOMIC_RELEASE);
+	}
+
+public:
+
+	explicit io_uring_storage(string const & filename) : pread_storage{filename}, _unsubmitted{0}, _in_flight{0}, _broken{false}, _max_read{0}
+	{
+		_setup();
+	}
+
+	virtual ~io_uring_storage()
+	{
+		if (_ring_fd < 0)
+			return;
+		munmap(_sqes, _params.sq_entries*sizeof(io_uring_sqe));
+		if (_cq_ring != _sq_ring)
+			munmap(_cq_ring, _cq_ring_size);
+		munmap(_sq_ring, _sq_ring_size);
+		close(_ring_fd);
+	}
+
+	virtual auto backend() const -> storage_backend_e override
+	{
+		return _ring_fd < 0 ? STORAGE_PREAD : STORAGE_IO_URING;
+	}
+
+	/**
+	 * Limit the size of each read request, 0 for no limit. Runs are then
+	 * completed by short reads, used to exercise that path.
+	 **/
+	void set_max_read_size(uint64_t size)
+	{
+		unique_lock<mutex> l{_ring_lock};
+		_max_read = size;
+	}
+
+	virtual void fetch(vector<storage_extent_t> const & extents, bool parallel, function<void(size_t, uint8_t const *)> const & func) override
+	{
+		if (_ring_fd < 0) {
+			pread_storage::fetch(extents, parallel, func);
+			return;
+		}
+
+		vector<size_t> order;
+		vector<run_t> runs;
+		plan_runs(extents, order, runs);
+
+		// split runs in batches of at most QUEUE_DEPTH runs and MAX_BATCH_SIZE bytes.
+		vector<size_t> batches{0};
+		uint64_t batch_size = 0;
+		for (size_t k = 0; k < runs.size(); ++k) {
+			if (k > batches.back() and (k - batches.back() >= QUEUE_DEPTH or batch_size + runs[k].size > MAX_BATCH_SIZE)) {
+				batches.push_back(k);
+				batch_size = 0;
+			}
+			batch_size += runs[k].size;
+		}
+		batches.push_back(runs.size());
+
+		unique_lock<mutex> l{_ring_lock};
+		if (_broken) {
+			l.unlock();
+			pread_storage::fetch(extents, parallel, func);
+			return;
+		}
+
+		vector<_request> requests(runs.size());
+		vector<char> done(runs.size(), false);
+		exception_ptr error;
+
+		auto submit = [&](size_t b) {
+			for (size_t k = batches[b]; k < batches[b+1]; ++k) {
+				requests[k].buffer = _pool.acquire(runs[k].size, requests[k].capacity);
+				requests[k].done = 0;
+				_queue(runs, requests, k);
+			}
+			_enter(0);
+		};
+
+		// short reads queued again by _reap are always submitted, even if
+		// request k is complete, later requests may wait on them.
+		auto wait = [&](size_t b) {
+			for (size_t k = batches[b]; k < batches[b+1]; ++k) {
+				while (not done[k]) {
+					_reap(runs, requests, done, error);
+					if (_unsubmitted > 0 or not done[k])
+						_enter(done[k] ? 0 : 1);
+				}
+			}
+		};
+
+		size_t nbatch = batches.size()-1;
+		try {
+			if (nbatch > 0)
+				submit(0);
+			for (size_t b = 0; b < nbatch; ++b) {
+				if (b+1 < nbatch)
+					submit(b+1);
+				wait(b);
+
+				if (not error) {
+					auto process = [&](size_t k) {
+						k += batches[b];
+						_dispatch(runs[k], requests[k].buffer.get(), extents, order, func);
+					};
+					try {
+						if (parallel) {
+							default_thread_pool()->parallel_for(batches[b+1]-batches[b], process);
+						} else {
+							for (size_t k = 0; k < batches[b+1]-batches[b]; ++k)
+								process(k);
+						}
+					} catch (...) {
+						error = current_exception();
+					}
+				}
+
+				for (size_t k = batches[b]; k < batches[b+1]; ++k)
+					_pool.release(std::move(requests[k].buffer), requests[k].capacity);
+
+				if (error)
+					rethrow_exception(error);
+			}
+		} catch (...) {
+			// buffers of reads in flight are released once the kernel is done
+			// with them, if the ring cannot tell they are leaked.
+			if (_drain()) {
+				for (auto & q: requests) {
+					if (q.buffer)
+						_pool.release(std::move(q.buffer), q.capacity);
+				}
+			} else {
+				_broken = true;
+				for (auto & q: requests)
+					q.buffer.release();
+			}
+			throw;
+		}
+	}
+
+};
+
+#endif
+
+// open the file with the given backend.
+static inline shared_ptr<file_storage> make_storage(string const & filename, storage_backend_e backend)
+{
+	switch (backend) {
+	case STORAGE_MMAP:
+		return make_shared<file_storage>(filename);
+	case STORAGE_PREAD:
+		return make_shared<pread_storage>(filename);
+	case STORAGE_IO_URING:
+#ifdef HAVE_LINUX_IO_URING_H
+		return make_shared<io_uring_storage>(filename);
+#else
+		return make_shared<pread_storage>(filename);
+#endif
+	default:
+		throw EXCEPTION("Unknown storage backend (%d)", backend);
+	}
+}
+
+} // h5ng
+
+#endif /* SRC_H5NG_STORAGE_HXX_ */
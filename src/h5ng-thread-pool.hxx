@@ -0,0 +1,219 @@
+/*
+ * h5ng-thread-pool.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_THREAD_POOL_HXX_
+#define SRC_H5NG_THREAD_POOL_HXX_
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace h5ng {
+
+using namespace std;
+
+/**
+ * A fixed set of worker threads that execute queued jobs.
+ *
+ * The main entry point is parallel_for, the calling thread take part to the
+ * work, thus a pool of size 0 or nested call are always safe and progress.
+ **/
+class thread_pool {
+	vector<thread> _workers;
+	deque<function<void()>> _jobs;
+	mutex _lock;
+	condition_variable _cond;
+	bool _stop;
+
+	void _worker_loop()
+	{
+		while (true) {
+			function<void()> job;
+			{
+				unique_lock<mutex> l{_lock};
+				_cond.wait(l, [this]() { return _stop or not _jobs.empty(); });
+				if (_jobs.empty())
+					return; // stopped
+				job = std::move(_jobs.front());
+				_jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	// shared between the caller and the helper jobs of one parallel_for.
+	struct _parallel_for_state {
+		size_t count;
+		function<void(size_t)> func;
+		atomic<size_t> next;
+		atomic<bool> failed;
+		size_t done;
+		exception_ptr error;
+		mutex lock;
+		condition_variable cond;
+
+		_parallel_for_state(size_t count, function<void(size_t)> const & func) :
+			count{count}, func{func}, next{0}, failed{false}, done{0} { }
+
+		// process items until none is left, return when no more item can be taken.
+		void run()
+		{
+			size_t n = 0;
+			exception_ptr e;
+			size_t i;
+			while ((i = next++) < count) {
+				if (not failed) {
+					try {
+						func(i);
+					} catch (...) {
+						failed = true;
+						if (not e)
+							e = current_exception();
+					}
+				}
+				++n;
+			}
+
+			if (n == 0)
+				return;
+
+			unique_lock<mutex> l{lock};
+			if (e and not error)
+				error = e;
+			done += n;
+			if (done == count)
+				cond.notify_all();
+		}
+
+	};
+
+public:
+
+	explicit thread_pool(unsigned thread_count) : _stop{false}
+	{
+		for (unsigned i = 0; i < thread_count; ++i) {
+			_workers.emplace_back([this]() { _worker_loop(); });
+		}
+	}
+
+	thread_pool(thread_pool const &) = delete;
+	thread_pool & operator=(thread_pool const &) = delete;
+
+	~thread_pool()
+	{
+		{
+			unique_lock<mutex> l{_lock};
+			_stop = true;
+		}
+		_cond.notify_all();
+		for (auto & t: _workers) {
+			t.join();
+		}
+	}
+
+	// number of worker threads, the caller of parallel_for is not counted.
+	unsigned size() const
+	{
+		return _workers.size();
+	}
+
+	void push(function<void()> job)
+	{
+		{
+			unique_lock<mutex> l{_lock};
+			_jobs.push_back(std::move(job));
+		}
+		_cond.notify_one();
+	}
+
+	/**
+	 * Call func(i) for i in [0, count[ using the pool and the calling thread,
+	 * return when all calls are done. The first exception thrown by func is
+	 * rethrown, remaining items are skipped.
+	 **/
+	template<typename F>
+	void parallel_for(size_t count, F && func)
+	{
+		if (count == 0)
+			return;
+
+		if (count == 1 or _workers.empty()) {
+			for (size_t i = 0; i < count; ++i)
+				func(i);
+			return;
+		}
+
+		auto state = make_shared<_parallel_for_state>(count, function<void(size_t)>{func});
+		size_t helpers = std::min<size_t>(count-1, _workers.size());
+		for (size_t i = 0; i < helpers; ++i) {
+			push([state]() { state->run(); });
+		}
+
+		state->run();
+
+		// helpers that start late do not touch func, thus we only wait for items.
+		unique_lock<mutex> l{state->lock};
+		state->cond.wait(l, [&state]() { return state->done == state->count; });
+		if (state->error)
+			rethrow_exception(state->error);
+	}
+
+	static unsigned default_thread_count()
+	{
+		unsigned n = thread::hardware_concurrency();
+		return n > 1 ? n-1 : 0; // the caller is the last thread
+	}
+
+};
+
+struct _default_thread_pool {
+	static mutex & lock()
+	{
+		static mutex l;
+		return l;
+	}
+
+	static shared_ptr<thread_pool> & instance()
+	{
+		static shared_ptr<thread_pool> pool;
+		return pool;
+	}
+};
+
+/**
+ * Return the pool used to decode and read data in parallel, it is created on
+ * first use with one thread per core.
+ **/
+static inline shared_ptr<thread_pool> default_thread_pool()
+{
+	unique_lock<mutex> l{_default_thread_pool::lock()};
+	auto & pool = _default_thread_pool::instance();
+	if (not pool)
+		pool = make_shared<thread_pool>(thread_pool::default_thread_count());
+	return pool;
+}
+
+/**
+ * Set the number of thread used by the library, including the calling thread,
+ * 1 disable threading. Reads in progress keep the previous pool.
+ **/
+static inline void set_thread_count(unsigned thread_count)
+{
+	unique_lock<mutex> l{_default_thread_pool::lock()};
+	_default_thread_pool::instance() = make_shared<thread_pool>(thread_count > 0 ? thread_count-1 : 0);
+}
+
+} // h5ng
+
+#endif /* SRC_H5NG_THREAD_POOL_HXX_ */
@@ -0,0 +1,953 @@
+/*
+ * h5ng-writer.cxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#include "h5ng-writer.hxx"
+
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "h5ng-spec.hxx"
+#include "h5ng-filters.hxx"
+#include "h5ng-thread-pool.hxx"
+#include "jenkins_lookup3.hxx"
+
+namespace h5ng {
+
+// files are always written with 8 bytes offsets and lengths.
+using writer_spec = spec_defs<8, 8>;
+
+static uint64_t const WRITER_UNDEF_ADDRESS = ~0ul;
+static uint64_t const WRITER_UNLIMITED = ~0ul;
+
+// default K of the chunk B-tree when the superblock does not store it, the
+// reference implementation always read nodes of 2K entries.
+static uint64_t const WRITER_CHUNK_BTREE_K = 32;
+
+static uint8_t const WRITER_SUPERBLOCK_SIGNATURE[8] = {0x89, 'H', 'D', 'F', '\r', '\n', 0x1a, '\n'};
+
+// Append little endian values to a buffer.
+struct _writer_encoder {
+	vector<uint8_t> data;
+
+	template<typename T>
+	void put(T x)
+	{
+		uint64_t pos = data.size();
+		data.resize(pos+sizeof(T));
+		std::memcpy(&data[pos], &x, sizeof(T));
+	}
+
+	void put(void const * x, uint64_t size)
+	{
+		auto p = reinterpret_cast<uint8_t const *>(x);
+		data.insert(data.end(), p, p+size);
+	}
+
+	// append size zeroed bytes and return their address, to be filled with the
+	// spec accessors before the next append.
+	uint8_t * reserve(uint64_t size)
+	{
+		uint64_t pos = data.size();
+		data.resize(pos+size, 0);
+		return &data[pos];
+	}
+
+	uint64_t size() const
+	{
+		return data.size();
+	}
+
+};
+
+// Object header version 2 with a single chunk.
+struct _writer_object_header {
+	_writer_encoder messages;
+
+	void add(uint8_t type, _writer_encoder const & body, uint8_t flags = 0)
+	{
+		using spec = writer_spec::message_header_v2_spec;
+		if (body.size() > 0xffffu)
+			throw EXCEPTION("Object header message too large (%lu)", body.size());
+		auto h = messages.reserve(spec::size);
+		spec::type::get(h) = type;
+		spec::size_of_message::get(h) = body.size();
+		spec::flags::get(h) = flags;
+		messages.put(&body.data[0], body.size());
+	}
+
+	vector<uint8_t> encode() const
+	{
+		using spec = writer_spec::object_header_v2_spec;
+		_writer_encoder out;
+		auto h = out.reserve(spec::size);
+		std::memcpy(spec::signature::get(h), "OHDR", 4);
+		spec::version::get(h) = 2;
+		spec::flags::get(h) = 0b0000'0010u; // size of chunk stored on 4 bytes
+		out.put<uint32_t>(messages.size());
+		out.put(&messages.data[0], messages.size());
+		out.put<uint32_t>(jenkins_lookup3(&out.data[0], out.size()));
+		return std::move(out.data);
+	}
+
+};
+
+// A metadata block written again by each flush.
+struct _writer_block {
+	uint64_t address = WRITER_UNDEF_ADDRESS;
+	uint64_t capacity = 0;
+};
+
+struct _writer_node {
+	_writer_block header_block; //< object header written by the previous flush
+
+	virtual ~_writer_node() = default;
+	// encode pending data that are not yet written.
+	virtual void flush_pending() = 0;
+	// write the object header and return its address.
+	virtual uint64_t write_header() = 0;
+};
+
+struct _h5writer_file {
+	int fd;
+	string filename;
+	atomic<uint64_t> eof;
+	bool closed;
+
+	shared_ptr<thread_pool> pool;
+	mutex lock;
+	condition_variable cond;
+	uint64_t pending;
+	uint64_t max_pending;
+	exception_ptr error;
+
+	struct group;
+	shared_ptr<group> root;
+
+	_h5writer_file(string const & filename);
+
+	~_h5writer_file()
+	{
+		if (fd >= 0)
+			::close(fd);
+	}
+
+	uint64_t allocate(uint64_t size)
+	{
+		return eof.fetch_add(size);
+	}
+
+	void write_at(void const * data, uint64_t size, uint64_t offset)
+	{
+		auto cur = reinterpret_cast<uint8_t const *>(data);
+		while (size > 0) {
+			ssize_t ret = ::pwrite(fd, cur, size, offset);
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+				throw EXCEPTION("Fail to write `%s' (%s)", filename.c_str(), strerror(errno));
+			}
+			cur += ret;
+			offset += ret;
+			size -= ret;
+		}
+	}
+
+	/**
+	 * Return the address of the new version of block, size bytes long. The
+	 * previous version is reused if it is large enough, otherwise the block
+	 * is moved to a new allocation twice as large as needed, thus a block that
+	 * grows with each flush leaves a bounded amount of unused space.
+	 **/
+	uint64_t reserve_block(_writer_block & block, uint64_t size)
+	{
+		if (size > block.capacity) {
+			block.capacity = block.address == WRITER_UNDEF_ADDRESS ? size : 2*size;
+			block.address = allocate(block.capacity);
+		}
+		return block.address;
+	}
+
+	// write data as the new version of block and return its address.
+	uint64_t write_block(vector<uint8_t> const & data, _writer_block & block)
+	{
+		uint64_t address = reserve_block(block, data.size());
+		write_at(&data[0], data.size(), address);
+		return address;
+	}
+
+	// rethrow the first error of jobs, the caller holds lock.
+	void _rethrow(unique_lock<mutex> &)
+	{
+		if (error) {
+			auto e = error;
+			error = nullptr;
+			rethrow_exception(e);
+		}
+	}
+
+	/**
+	 * Run the job on the thread pool, the caller is blocked while too many jobs
+	 * are pending thus memory used by queued chunks is bounded. Errors are
+	 * reported by the next call to submit or wait.
+	 **/
+	void submit(function<void()> job)
+	{
+		if (pool->size() == 0) {
+			job();
+			return;
+		}
+
+		{
+			unique_lock<mutex> l{lock};
+			cond.wait(l, [this]() { return pending < max_pending; });
+			_rethrow(l);
+			++pending;
+		}
+
+		pool->push([this, job]() mutable {
+			exception_ptr e;
+			try {
+				job();
+			} catch (...) {
+				e = current_exception();
+			}
+			// captures of the job, like chunk row buffers that are returned to
+			// their dataset, must be released before wait() can return.
+			job = nullptr;
+			unique_lock<mutex> l{lock};
+			if (e and not error)
+				error = e;
+			--pending;
+			cond.notify_all();
+		});
+	}
+
+	void wait()
+	{
+		unique_lock<mutex> l{lock};
+		cond.wait(l, [this]() { return pending == 0; });
+		_rethrow(l);
+	}
+
+	shared_ptr<group> find_parent(string const & path, string & name);
+
+	void write_superblock(uint64_t root_address)
+	{
+		// the unused room of the last blocks may end after the last write.
+		if (::ftruncate(fd, eof.load()) < 0)
+			throw EXCEPTION("Fail to resize `%s' (%s)", filename.c_str(), strerror(errno));
+
+		using spec = writer_spec::superblock_v2_spec;
+		_writer_encoder out;
+		auto h = out.reserve(spec::size);
+		std::memcpy(spec::signature::get(h), WRITER_SUPERBLOCK_SIGNATURE, 8);
+		spec::superblock_version::get(h) = 2;
+		spec::size_of_offsets::get(h) = 8;
+		spec::size_of_length::get(h) = 8;
+		spec::file_consistency_flags::get(h) = 0;
+		spec::base_address::get(h) = 0;
+		spec::superblock_extension_address::get(h) = WRITER_UNDEF_ADDRESS;
+		spec::end_of_file_address::get(h) = eof.load();
+		spec::root_group_object_header_address::get(h) = root_address;
+		spec::superblock_checksum::get(h) = jenkins_lookup3(h, spec::superblock_checksum::offset);
+		write_at(h, spec::size, 0);
+	}
+
+};
+
+struct _h5writer_file::group : public _writer_node {
+	_h5writer_file * file;
+	map<string, shared_ptr<_writer_node>> links;
+
+	group(_h5writer_file * file) : file{file} { }
+
+	virtual void flush_pending() override
+	{
+		for (auto & x: links)
+			x.second->flush_pending();
+	}
+
+	virtual uint64_t write_header() override
+	{
+		_writer_object_header header;
+
+		_writer_encoder link_info;
+		link_info.put<uint8_t>(0); // version
+		link_info.put<uint8_t>(0); // flags
+		link_info.put<uint64_t>(WRITER_UNDEF_ADDRESS); // no fractal heap, links are compact
+		link_info.put<uint64_t>(WRITER_UNDEF_ADDRESS); // no name index
+		header.add(MSG_LINK_INFO_ID, link_info);
+
+		_writer_encoder group_info;
+		group_info.put<uint8_t>(0); // version
+		group_info.put<uint8_t>(0); // flags
+		header.add(MSG_GROUP_INFO_ID, group_info);
+
+		for (auto & x: links) {
+			uint64_t address = x.second->write_header();
+			auto const & name = x.first;
+			_writer_encoder link;
+			link.put<uint8_t>(1); // version
+			if (name.size() < 256) {
+				link.put<uint8_t>(0); // hard link, name length on 1 byte
+				link.put<uint8_t>(name.size());
+			} else {
+				link.put<uint8_t>(1); // hard link, name length on 2 bytes
+				link.put<uint16_t>(name.size());
+			}
+			link.put(name.data(), name.size());
+			link.put<uint64_t>(address);
+			header.add(MSG_LINK_ID, link);
+		}
+
+		return file->write_block(header.encode(), header_block);
+	}
+
+	enum : uint8_t {
+		MSG_LINK_INFO_ID  = 0x02u,
+		MSG_LINK_ID       = 0x06u,
+		MSG_GROUP_INFO_ID = 0x0Au
+	};
+
+};
+
+struct h5dataset_writer::_dataset : public _writer_node {
+
+	enum : uint8_t {
+		MSG_DATASPACE_ID       = 0x01u,
+		MSG_DATATYPE_ID        = 0x03u,
+		MSG_FILL_VALUE_ID      = 0x05u,
+		MSG_DATA_LAYOUT_ID     = 0x08u,
+		MSG_FILTER_PIPELINE_ID = 0x0Bu
+	};
+
+	enum : uint8_t {
+		MSG_FLAG_CONSTANT      = 0x01u
+	};
+
+	_h5writer_file * file;
+	writer_datatype_t datatype;
+	vector<uint64_t> shape;
+	bool unlimited;
+	vector<uint64_t> chunk_shape;
+	object_data_storage_filter_pipeline_t pipeline;
+
+	uint64_t row_size;     //< bytes of one element of the first dimension
+	uint64_t rows;         //< number of appended rows
+
+	uint64_t contiguous_address;
+
+	uint64_t chunk_size;          //< bytes of one chunk
+	uint64_t chunks_per_row;      //< chunks that share the same first dimension offset
+	bool row_is_chunk;            //< one row of chunks is exactly one chunk without padding
+
+	// rows of the current chunk row, staged until the chunk row is full.
+	shared_ptr<vector<uint8_t>> staging;
+	uint64_t staged;
+
+	mutex lock;
+	map<vector<uint64_t>, chunk_desc_t> chunks;
+	map<vector<uint64_t>, _writer_block> partial_chunks; //< chunks of a partial chunk row written by flush
+	vector<vector<uint8_t> *> spare_buffers;
+
+	vector<_writer_block> btree_levels; //< chunk B-tree nodes of each level, from leaves
+
+	_dataset(_h5writer_file * file, writer_datatype_t const & datatype, vector<uint64_t> const & shape, dataset_options_t const & options) :
+		file{file},
+		datatype{datatype},
+		shape{shape},
+		unlimited{options.unlimited},
+		chunk_shape{options.chunk_shape},
+		row_size{datatype.size},
+		rows{0},
+		contiguous_address{WRITER_UNDEF_ADDRESS},
+		chunk_size{datatype.size},
+		chunks_per_row{1},
+		row_is_chunk{true},
+		staged{0}
+	{
+		if (shape.empty() or shape.size() > 32)
+			throw EXCEPTION("Invalid dataset rank (%lu)", shape.size());
+		if (datatype.size != 1 and datatype.size != 2 and datatype.size != 4 and datatype.size != 8)
+			throw EXCEPTION("Unsupported element size (%u)", datatype.size);
+		if (datatype.floating and datatype.size != 4 and datatype.size != 8)
+			throw EXCEPTION("Unsupported floating point size (%u)", datatype.size);
+
+		if (unlimited)
+			this->shape[0] = 0; // the extent grows with appends
+
+		for (size_t i = 1; i < shape.size(); ++i)
+			row_size *= shape[i];
+
+		if (options.shuffle)
+			pipeline.filters.emplace_back(FILTER_SHUFFLE, "", 1u, vector<uint32_t>{datatype.size});
+		if (options.deflate_level >= 0)
+			pipeline.filters.emplace_back(FILTER_DEFLATE, "", 1u, vector<uint32_t>{static_cast<uint32_t>(std::min(options.deflate_level, 9))});
+
+		if (chunk_shape.empty()) {
+			if (unlimited)
+				throw EXCEPTION("Unlimited dataset must be chunked");
+			if (not pipeline.filters.empty())
+				throw EXCEPTION("Filtered dataset must be chunked");
+			uint64_t size = row_size*shape[0];
+			if (size > 0)
+				contiguous_address = file->allocate(size);
+			return;
+		}
+
+		if (chunk_shape.size() != shape.size())
+			throw EXCEPTION("chunk rank (%lu) does not match dataset rank (%lu)", chunk_shape.size(), shape.size());
+
+		for (size_t i = 0; i < shape.size(); ++i) {
+			if (chunk_shape[i] == 0 or chunk_shape[i] > 0xffffffffu)
+				throw EXCEPTION("Invalid chunk shape");
+			chunk_size *= chunk_shape[i];
+			if (i > 0) {
+				chunks_per_row *= (shape[i]+chunk_shape[i]-1)/chunk_shape[i];
+				row_is_chunk = row_is_chunk and chunk_shape[i] == shape[i];
+			}
+		}
+
+		if (chunk_size > 0xffffffffu)
+			throw EXCEPTION("Chunk too large (%lu bytes)", chunk_size);
+
+		staging = _take_buffer();
+	}
+
+	// return a buffer for one chunk row, buffers come back when jobs release them.
+	shared_ptr<vector<uint8_t>> _take_buffer()
+	{
+		vector<uint8_t> * buffer = nullptr;
+		{
+			unique_lock<mutex> l{lock};
+			if (not spare_buffers.empty()) {
+				buffer = spare_buffers.back();
+				spare_buffers.pop_back();
+			}
+		}
+
+		if (not buffer)
+			buffer = new vector<uint8_t>(row_size*chunk_shape[0]);
+
+		return shared_ptr<vector<uint8_t>>{buffer, [this](vector<uint8_t> * p) {
+			unique_lock<mutex> l{lock};
+			spare_buffers.push_back(p);
+		}};
+	}
+
+	virtual ~_dataset()
+	{
+		staging.reset();
+		for (auto p: spare_buffers)
+			delete p;
+	}
+
+	vector<uint64_t> current_shape() const
+	{
+		auto ret = shape;
+		if (unlimited)
+			ret[0] = rows;
+		return ret;
+	}
+
+	/**
+	 * Write a chunk and add it to the index. Chunks of a partial chunk row are
+	 * written again by the next flush or once completed, in place if they fit,
+	 * thus they are allocated with room to grow up to the raw chunk size.
+	 **/
+	void _store_chunk(vector<uint64_t> const & scaled, uint8_t const * data, uint64_t size, bool partial)
+	{
+		_writer_block block;
+		{
+			unique_lock<mutex> l{lock};
+			auto x = partial_chunks.find(scaled);
+			if (x != partial_chunks.end())
+				block = x->second;
+		}
+
+		if (size > block.capacity) {
+			block.capacity = partial ? std::max(size, std::min(2*size, chunk_size)) : size;
+			block.address = file->allocate(block.capacity);
+		}
+
+		file->write_at(data, size, block.address);
+		chunk_desc_t desc{static_cast<uint32_t>(size), 0u, block.address};
+		unique_lock<mutex> l{lock};
+		auto x = chunks.emplace(scaled, desc);
+		if (not x.second) // a partial chunk written by a previous flush
+			x.first->second = desc;
+		if (partial)
+			partial_chunks[scaled] = block;
+		else
+			partial_chunks.erase(scaled);
+	}
+
+	// copy the chunk at scaled from the chunk row src of nrows rows, dst is zeroed.
+	void _gather(uint8_t const * src, uint64_t nrows, uint64_t const * scaled, uint8_t * dst) const
+	{
+		size_t const R = shape.size();
+		vector<uint64_t> count(R), src_stride(R), dst_stride(R);
+		count[0] = nrows;
+		for (size_t d = 1; d < R; ++d)
+			count[d] = std::min(chunk_shape[d], shape[d]-scaled[d]*chunk_shape[d]);
+
+		src_stride[R-1] = datatype.size;
+		dst_stride[R-1] = datatype.size;
+		for (size_t d = R-1; d > 0; --d) {
+			src_stride[d-1] = src_stride[d]*shape[d];
+			dst_stride[d-1] = dst_stride[d]*chunk_shape[d];
+		}
+
+		for (size_t d = 1; d < R; ++d)
+			src += scaled[d]*chunk_shape[d]*src_stride[d];
+
+		uint64_t run = count[R-1]*datatype.size;
+		if (R == 1) {
+			std::memcpy(dst, src, run);
+			return;
+		}
+
+		vector<uint64_t> idx(R-1, 0);
+		while (true) {
+			uint64_t so = 0, dso = 0;
+			for (size_t d = 0; d < R-1; ++d) {
+				so += idx[d]*src_stride[d];
+				dso += idx[d]*dst_stride[d];
+			}
+			std::memcpy(dst+dso, src+so, run);
+
+			size_t d = R-2;
+			while (++idx[d] == count[d]) {
+				idx[d] = 0;
+				if (d == 0)
+					return;
+				--d;
+			}
+		}
+	}
+
+	/**
+	 * Encode and write all chunks of a chunk row, one job per chunk. The row
+	 * buffer is released when the last job is done. partial is true if the
+	 * chunk row will be written again.
+	 **/
+	void _write_chunk_row(shared_ptr<vector<uint8_t>> const & row, uint64_t nrows, uint64_t row_index, bool partial)
+	{
+		size_t const R = shape.size();
+		for (uint64_t j = 0; j < chunks_per_row; ++j) {
+			vector<uint64_t> scaled(R);
+			scaled[0] = row_index;
+			uint64_t k = j;
+			for (size_t d = R-1; d > 0; --d) {
+				uint64_t n = (shape[d]+chunk_shape[d]-1)/chunk_shape[d];
+				scaled[d] = k%n;
+				k /= n;
+			}
+
+			file->submit([this, row, nrows, scaled, partial]() {
+				thread_local vector<uint8_t> chunk;
+				thread_local vector<uint8_t> encoded;
+				thread_local vector<uint8_t> tmp;
+
+				uint8_t const * data = &(*row)[0];
+				if (not row_is_chunk or nrows != chunk_shape[0]) {
+					chunk.assign(chunk_size, 0);
+					_gather(data, nrows, &scaled[0], &chunk[0]);
+					data = &chunk[0];
+				}
+
+				if (pipeline.filters.empty()) {
+					_store_chunk(scaled, data, chunk_size, partial);
+				} else {
+					filter_pipeline_encode(pipeline, data, chunk_size, encoded, tmp);
+					_store_chunk(scaled, &encoded[0], encoded.size(), partial);
+				}
+			});
+		}
+	}
+
+	void append(void const * data, uint64_t count)
+	{
+		if (file->closed)
+			throw EXCEPTION("File is closed");
+		if (not unlimited and rows+count > shape[0])
+			throw EXCEPTION("Too many rows appended (%lu > %lu)", rows+count, shape[0]);
+
+		auto src = reinterpret_cast<uint8_t const *>(data);
+
+		if (chunk_shape.empty()) {
+			if (count > 0)
+				file->write_at(src, count*row_size, contiguous_address+rows*row_size);
+			rows += count;
+			return;
+		}
+
+		uint64_t const c0 = chunk_shape[0];
+		while (count > 0) {
+			// rows that already are a chunk are written without copy.
+			if (staged == 0 and count >= c0 and row_is_chunk and pipeline.filters.empty()) {
+				vector<uint64_t> scaled(shape.size(), 0);
+				scaled[0] = rows/c0;
+				_store_chunk(scaled, src, chunk_size, false);
+				src += c0*row_size;
+				rows += c0;
+				count -= c0;
+				continue;
+			}
+
+			uint64_t n = std::min(count, c0-staged);
+			std::memcpy(&(*staging)[staged*row_size], src, n*row_size);
+			staged += n;
+			rows += n;
+			src += n*row_size;
+			count -= n;
+
+			// the last chunk row of fixed dataset is complete when the dataset is full.
+			if (staged == c0 or (not unlimited and rows == shape[0])) {
+				_write_chunk_row(staging, staged, (rows-1)/c0, false);
+				staging = _take_buffer();
+				staged = 0;
+			}
+		}
+	}
+
+	virtual void flush_pending() override
+	{
+		if (staged == 0)
+			return;
+		// rows stay staged, the chunk row is written again when completed.
+		auto copy = _take_buffer();
+		std::copy(staging->begin(), staging->begin()+staged*row_size, copy->begin());
+		_write_chunk_row(copy, staged, (rows-1)/chunk_shape[0], true);
+	}
+
+	void _encode_chunk_key(_writer_encoder & out, uint32_t size, uint32_t filters, uint64_t const * scaled, uint64_t delta) const
+	{
+		using spec = writer_spec::b_tree_v1_chunk_key_spec;
+		auto h = out.reserve(spec::size);
+		spec::chunk_size::get(h) = size;
+		spec::filter_mask::get(h) = filters;
+		// keys store the offset of the first element, the element size dimension is 0.
+		for (size_t d = 0; d < shape.size(); ++d)
+			out.put<uint64_t>((scaled[d]+delta)*chunk_shape[d]);
+		out.put<uint64_t>(0);
+	}
+
+	/**
+	 * Write the chunk index as a B-tree v1, nodes are filled up to 2K entries
+	 * and written level by level from leaves to root. Nodes of each level are
+	 * one block, rewritten in place by the next flush if it fits.
+	 **/
+	uint64_t _write_chunk_btree()
+	{
+		using hdr = writer_spec::b_tree_v1_hdr_spec;
+
+		if (chunks.empty())
+			return WRITER_UNDEF_ADDRESS;
+
+		uint64_t const fanout = 2*WRITER_CHUNK_BTREE_K;
+		uint64_t const key_size = writer_spec::b_tree_v1_chunk_key_spec::size+(shape.size()+1)*8;
+		uint64_t const node_size = hdr::size+fanout*8+(fanout+1)*key_size;
+
+		struct entry {
+			vector<uint8_t> key;
+			uint64_t address;
+		};
+
+		vector<entry> level;
+		for (auto const & x: chunks) {
+			_writer_encoder key;
+			_encode_chunk_key(key, x.second.size_of_chunk, x.second.filters, &x.first[0], 0);
+			level.push_back(entry{std::move(key.data), x.second.address});
+		}
+
+		// the right key of the last chunk is beyond the last chunk.
+		_writer_encoder right_key;
+		_encode_chunk_key(right_key, 0, 0, &chunks.rbegin()->first[0], 1);
+
+		for (uint8_t depth = 0;; ++depth) {
+			uint64_t node_count = (level.size()+fanout-1)/fanout;
+			if (btree_levels.size() <= depth)
+				btree_levels.resize(depth+1);
+			uint64_t base = file->reserve_block(btree_levels[depth], node_count*node_size);
+			vector<entry> parent;
+
+			_writer_encoder out;
+			for (uint64_t i = 0; i < node_count; ++i) {
+				uint64_t bgn = i*fanout;
+				uint64_t end = std::min<uint64_t>(bgn+fanout, level.size());
+
+				auto h = out.reserve(hdr::size);
+				std::memcpy(hdr::signature::get(h), "TREE", 4);
+				hdr::node_type::get(h) = 1; // raw data chunks
+				hdr::node_level::get(h) = depth;
+				hdr::entries_used::get(h) = end-bgn;
+				hdr::left_sibling_address::get(h) = i > 0 ? base+(i-1)*node_size : WRITER_UNDEF_ADDRESS;
+				hdr::right_sibling_address::get(h) = i+1 < node_count ? base+(i+1)*node_size : WRITER_UNDEF_ADDRESS;
+
+				for (uint64_t k = bgn; k < end; ++k) {
+					out.put(&level[k].key[0], key_size);
+					out.put<uint64_t>(level[k].address);
+				}
+
+				auto const & last = end < level.size() ? level[end].key : right_key.data;
+				out.put(&last[0], key_size);
+				out.reserve(node_size-(out.size()-i*node_size)); // unused entries
+
+				parent.push_back(entry{level[bgn].key, base+i*node_size});
+			}
+
+			file->write_at(&out.data[0], out.size(), base);
+
+			if (node_count == 1)
+				return base;
+
+			level = std::move(parent);
+		}
+	}
+
+	virtual uint64_t write_header() override
+	{
+		_writer_object_header header;
+		size_t const R = shape.size();
+
+		auto cur_shape = current_shape();
+
+		_writer_encoder dataspace;
+		{
+			using spec = writer_spec::message_dataspace_spec;
+			auto h = dataspace.reserve(spec::size_v2);
+			spec::version::get(h) = 2;
+			spec::rank::get(h) = R;
+			spec::flags::get(h) = 0b0000'0001u; // maximum dimensions are present
+			spec::reserved_v2::get(h) = 1; // simple dataspace
+			for (auto x: cur_shape)
+				dataspace.put<uint64_t>(x);
+			for (size_t i = 0; i < R; ++i)
+				dataspace.put<uint64_t>((i == 0 and unlimited) ? WRITER_UNLIMITED : shape[i]);
+		}
+		header.add(MSG_DATASPACE_ID, dataspace);
+
+		_writer_encoder dtype;
+		{
+			using spec = writer_spec::message_datatype_spec;
+			auto h = dtype.reserve(spec::size);
+			spec::class_and_version::get(h) = (1u<<4) | (datatype.floating ? 1u : 0u);
+			spec::size_of_elements::get(h) = datatype.size;
+			if (datatype.floating) {
+				using prop = writer_spec::datatype_property_class1_spec;
+				spec::class_bit_fields_0::get(h) = 0b0010'0000u; // implied mantissa msb
+				spec::class_bit_fields_1::get(h) = datatype.size*8-1; // sign location
+				auto p = dtype.reserve(prop::size);
+				bool single = datatype.size == 4;
+				prop::bit_offset::get(p) = 0;
+				prop::bit_precision::get(p) = datatype.size*8;
+				prop::exponant_location::get(p) = single ? 23 : 52;
+				prop::exponant_size::get(p) = single ? 8 : 11;
+				prop::mantissa_location::get(p) = 0;
+				prop::mantissa_size::get(p) = single ? 23 : 52;
+				prop::exponant_bias::get(p) = single ? 127 : 1023;
+			} else {
+				using prop = writer_spec::datatype_property_class0_spec;
+				spec::class_bit_fields_0::get(h) = datatype.is_signed ? 0b0000'1000u : 0u;
+				auto p = dtype.reserve(prop::size);
+				prop::bit_offset::get(p) = 0;
+				prop::bit_precision::get(p) = datatype.size*8;
+			}
+		}
+		header.add(MSG_DATATYPE_ID, dtype, MSG_FLAG_CONSTANT);
+
+		_writer_encoder fill;
+		{
+			// allocation early for contiguous, incremental for chunks, fill if set, fill value is 0.
+			uint8_t allocation = chunk_shape.empty() ? 1u : 3u;
+			fill.put<uint8_t>(3); // version
+			fill.put<uint8_t>(allocation | (2u<<2) | (1u<<5));
+			fill.put<uint32_t>(datatype.size);
+			fill.reserve(datatype.size);
+		}
+		header.add(MSG_FILL_VALUE_ID, fill, MSG_FLAG_CONSTANT);
+
+		_writer_encoder layout;
+		{
+			using spec = writer_spec::message_data_layout_v3_spec;
+			auto h = layout.reserve(spec::size);
+			spec::version::get(h) = 3;
+			if (chunk_shape.empty()) {
+				spec::layout_class::get(h) = 1;
+				layout.put<uint64_t>(contiguous_address);
+				layout.put<uint64_t>(row_size*shape[0]);
+			} else {
+				spec::layout_class::get(h) = 2;
+				uint64_t address = _write_chunk_btree();
+				layout.put<uint8_t>(R+1);
+				layout.put<uint64_t>(address);
+				for (auto x: chunk_shape)
+					layout.put<uint32_t>(x);
+				layout.put<uint32_t>(datatype.size);
+			}
+		}
+		header.add(MSG_DATA_LAYOUT_ID, layout);
+
+		if (not pipeline.filters.empty()) {
+			_writer_encoder filters;
+			using spec = writer_spec::message_data_storage_filter_pipeline_v2;
+			auto h = filters.reserve(spec::size);
+			spec::version::get(h) = 2;
+			spec::munber_of_filters::get(h) = pipeline.filters.size();
+			for (auto const & f: pipeline.filters) {
+				filters.put<uint16_t>(f.id); // no name for filters below 256
+				filters.put<uint16_t>(f.flags.to_ulong());
+				filters.put<uint16_t>(f.params.size());
+				for (auto x: f.params)
+					filters.put<uint32_t>(x);
+			}
+			header.add(MSG_FILTER_PIPELINE_ID, filters);
+		}
+
+		return file->write_block(header.encode(), header_block);
+	}
+
+};
+
+_h5writer_file::_h5writer_file(string const & filename) :
+	filename{filename},
+	eof{writer_spec::superblock_v2_spec::size},
+	closed{false},
+	pool{default_thread_pool()},
+	pending{0}
+{
+	fd = ::open(filename.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if (fd < 0)
+		throw EXCEPTION("Fail to create `%s' (%s)", filename.c_str(), strerror(errno));
+	max_pending = 2*(pool->size()+1);
+	root = make_shared<group>(this);
+}
+
+// split the path, the last component is returned in name.
+auto _h5writer_file::find_parent(string const & path, string & name) -> shared_ptr<group>
+{
+	vector<string> components;
+	size_t pos = 0;
+	while (pos < path.size()) {
+		size_t next = path.find('/', pos);
+		if (next == string::npos)
+			next = path.size();
+		if (next > pos)
+			components.push_back(path.substr(pos, next-pos));
+		pos = next+1;
+	}
+
+	if (components.empty())
+		throw EXCEPTION("Invalid object path `%s'", path.c_str());
+
+	auto cur = root;
+	for (size_t i = 0; i+1 < components.size(); ++i) {
+		auto x = cur->links.find(components[i]);
+		if (x == cur->links.end())
+			throw EXCEPTION("Group `%s' not found in `%s'", components[i].c_str(), path.c_str());
+		cur = dynamic_pointer_cast<group>(x->second);
+		if (not cur)
+			throw EXCEPTION("`%s' is not a group in `%s'", components[i].c_str(), path.c_str());
+	}
+
+	name = components.back();
+	if (cur->links.count(name))
+		throw EXCEPTION("Object `%s' already exists", path.c_str());
+	return cur;
+}
+
+h5writer::h5writer(string const & filename) :
+	_ptr{make_shared<_h5writer_file>(filename)}
+{
+
+}
+
+h5writer::~h5writer()
+{
+	// errors can only be reported by an explicit close.
+	try {
+		close();
+	} catch (...) {
+
+	}
+}
+
+void h5writer::create_group(string const & path)
+{
+	if (_ptr->closed)
+		throw EXCEPTION("File is closed");
+	string name;
+	auto parent = _ptr->find_parent(path, name);
+	parent->links[name] = make_shared<_h5writer_file::group>(_ptr.get());
+}
+
+h5dataset_writer h5writer::create_dataset(string const & path, writer_datatype_t const & datatype,
+		vector<uint64_t> const & shape, dataset_options_t const & options)
+{
+	if (_ptr->closed)
+		throw EXCEPTION("File is closed");
+	string name;
+	auto parent = _ptr->find_parent(path, name);
+	auto dataset = make_shared<h5dataset_writer::_dataset>(_ptr.get(), datatype, shape, options);
+	parent->links[name] = dataset;
+	return h5dataset_writer{_ptr, dataset};
+}
+
+void h5writer::flush()
+{
+	if (_ptr->closed)
+		throw EXCEPTION("File is closed");
+	_ptr->wait();
+	_ptr->root->flush_pending();
+	_ptr->wait();
+	uint64_t root_address = _ptr->root->write_header();
+	_ptr->write_superblock(root_address);
+}
+
+void h5writer::close()
+{
+	if (_ptr->closed)
+		return;
+	flush();
+	_ptr->closed = true;
+	if (::close(_ptr->fd) < 0) {
+		_ptr->fd = -1;
+		throw EXCEPTION("Fail to close `%s' (%s)", _ptr->filename.c_str(), strerror(errno));
+	}
+	_ptr->fd = -1;
+}
+
+void h5dataset_writer::append(void const * data, uint64_t count)
+{
+	_ptr->append(data, count);
+}
+
+void h5dataset_writer::write(void const * data)
+{
+	if (_ptr->unlimited)
+		throw EXCEPTION("write is not available for unlimited dataset, use append");
+	if (_ptr->rows != 0)
+		throw EXCEPTION("Dataset is already written");
+	_ptr->append(data, _ptr->shape[0]);
+}
+
+vector<uint64_t> h5dataset_writer::shape() const
+{
+	return _ptr->current_shape();
+}
+
+} // h5ng
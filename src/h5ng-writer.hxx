@@ -0,0 +1,124 @@
+/*
+ * h5ng-writer.hxx
+ *
+ *  Created on: 16 oct. 2026
+ *      Author: benoit.gschwind
+ */
+
+#ifndef SRC_H5NG_WRITER_HXX_
+#define SRC_H5NG_WRITER_HXX_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+#include "h5ng.hxx"
+
+namespace h5ng {
+
+using namespace std;
+
+// Elements written by the writer, always stored in the native byte order.
+struct writer_datatype_t {
+	bool floating;
+	bool is_signed;
+	uint32_t size;
+};
+
+template<typename T>
+static inline writer_datatype_t make_writer_datatype()
+{
+	static_assert(std::is_arithmetic<T>::value, "only arithmetic types can be written");
+	static_assert(not std::is_floating_point<T>::value or sizeof(T) == 4 or sizeof(T) == 8, "only IEEE single and double are supported");
+	return writer_datatype_t{std::is_floating_point<T>::value, std::is_signed<T>::value, sizeof(T)};
+}
+
+struct dataset_options_t {
+	vector<uint64_t> chunk_shape;  //< empty for contiguous layout
+	bool unlimited = false;        //< the first dimension grows with appends, require chunks
+	bool shuffle = false;
+	int deflate_level = -1;        //< -1 disable deflate
+};
+
+class h5writer;
+struct _h5writer_file;
+
+/**
+ * Write data of one dataset, rows are appended along the first dimension.
+ *
+ * Full chunks are encoded and written in the background, the chunk index and
+ * the current extent are written when the file is flushed. The writer must
+ * not be used after the file is closed, append is not thread safe.
+ **/
+class h5dataset_writer {
+	friend class h5writer;
+
+public:
+	struct _dataset;
+
+private:
+	shared_ptr<_h5writer_file> _file; //< keep the file alive while the dataset is in use
+	shared_ptr<_dataset> _ptr;
+
+	h5dataset_writer(shared_ptr<_h5writer_file> const & file, shared_ptr<_dataset> const & x) : _file{file}, _ptr{x} { }
+
+public:
+
+	h5dataset_writer(h5dataset_writer const &) = default;
+	h5dataset_writer & operator=(h5dataset_writer const &) = default;
+
+	// append count rows, a row is one element of the first dimension.
+	void append(void const * data, uint64_t count);
+
+	// write the whole dataset, only valid for dataset without unlimited dimension.
+	void write(void const * data);
+
+	// current extent of the dataset.
+	vector<uint64_t> shape() const;
+
+};
+
+/**
+ * Create a new file, an existing file is truncated.
+ *
+ * Objects are created with the format of HDF5 1.8 (superblock v2, object
+ * header v2, compact links and B-tree v1 chunk index), thus files are readable
+ * by this library and by the reference implementation. Metadata and chunks
+ * of partial chunk rows are written by flush and close, in place of their
+ * previous version when it is large enough, blocks that must grow are moved.
+ * Thus the file is only consistent after flush or close returns.
+ **/
+class h5writer {
+	shared_ptr<_h5writer_file> _ptr;
+
+public:
+
+	h5writer(string const & filename);
+	h5writer(h5writer const &) = delete;
+	h5writer & operator=(h5writer const &) = delete;
+	~h5writer();
+
+	// create a group, the parent group must exist.
+	void create_group(string const & path);
+
+	h5dataset_writer create_dataset(string const & path, writer_datatype_t const & datatype,
+			vector<uint64_t> const & shape, dataset_options_t const & options = dataset_options_t{});
+
+	template<typename T>
+	h5dataset_writer create_dataset(string const & path, vector<uint64_t> const & shape, dataset_options_t const & options = dataset_options_t{})
+	{
+		return create_dataset(path, make_writer_datatype<T>(), shape, options);
+	}
+
+	// wait pending chunks and write metadata, the file is then readable.
+	void flush();
+
+	void close();
+
+};
+
+} // h5ng
+
+#endif /* SRC_H5NG_WRITER_HXX_ */
@@ -10,8 +10,8 @@
 
 namespace h5ng {
 
-h5obj::h5obj(string const & filename) {
-	_ptr = make_shared<_h5file>(filename);
+h5obj::h5obj(string const & filename, storage_backend_e backend, index_mode_e index) {
+	_ptr = make_shared<_h5file>(filename, backend, index);
 }
 
 
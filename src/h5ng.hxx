@@ -15,6 +15,8 @@
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <atomic>
+#include <algorithm>
 
 #include <cstring>
 #include <cstdio>
@@ -27,6 +29,43 @@ using namespace std;
 
 class h5obj;
 
+struct _verbosity {
+	static atomic<int> & level()
+	{
+		static atomic<int> l{0};
+		return l;
+	}
+};
+
+/**
+ * Set the logging level of the library, 0 (the default) disable all logging
+ * thus objects can be opened and read concurrently without writing to cout.
+ **/
+static inline void set_verbosity(int level)
+{
+	_verbosity::level() = level;
+}
+
+static inline int verbosity()
+{
+	return _verbosity::level().load(memory_order_relaxed);
+}
+
+// How raw data of chunked datasets are read, metadata are always read from
+// the file mapping.
+enum storage_backend_e {
+	STORAGE_MMAP,     //< read through the file mapping, planned reads are prefetched
+	STORAGE_PREAD,    //< coalesced pread into aligned buffers
+	STORAGE_IO_URING  //< coalesced asynchronous reads with io_uring, fallback to pread if not available
+};
+
+// Use of the sidecar metadata index, see h5ng-index.hxx.
+enum index_mode_e {
+	INDEX_NONE,       //< object headers are parsed on demand
+	INDEX_USE,        //< use the sidecar index if it is up to date with the file
+	INDEX_BUILD       //< same as INDEX_USE, build and write the index if it is missing or out of date
+};
+
 struct chunk_desc_t {
 	uint32_t size_of_chunk;
 	uint32_t filters;
@@ -36,6 +75,83 @@ struct chunk_desc_t {
 	chunk_desc_t & operator=(chunk_desc_t const &) = default;
 };
 
+struct chunk_cache_stats_t {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t size;        //< bytes currently stored
+	uint64_t budget;      //< maximum bytes stored
+};
+
+/**
+ * Statistics of a set of values, NaN are counted apart and ignored otherwise.
+ * Accumulators of disjoint sets can be merged in any order, the variance is
+ * merged with the pairwise formula of Chan et al.
+ **/
+struct stats_accumulator_t {
+	uint64_t count = 0;        //< number of values that are not NaN
+	uint64_t nan_count = 0;
+	double min = numeric_limits<double>::infinity();
+	double max = -numeric_limits<double>::infinity();
+	double sum = 0.0;
+	double mean = 0.0;
+	double m2 = 0.0;           //< sum of squared differences to the mean
+	vector<uint64_t> histogram;
+
+	// population variance
+	double variance() const
+	{
+		return count > 0 ? m2/count : numeric_limits<double>::quiet_NaN();
+	}
+
+	void merge(stats_accumulator_t const & x)
+	{
+		nan_count += x.nan_count;
+		if (x.histogram.size() > histogram.size())
+			histogram.resize(x.histogram.size(), 0);
+		for (size_t i = 0; i < x.histogram.size(); ++i)
+			histogram[i] += x.histogram[i];
+
+		if (x.count == 0)
+			return;
+		if (count == 0) {
+			count = x.count;
+			min = x.min;
+			max = x.max;
+			sum = x.sum;
+			mean = x.mean;
+			m2 = x.m2;
+			return;
+		}
+
+		double n = count + x.count;
+		double delta = x.mean - mean;
+		mean += delta*(x.count/n);
+		m2 += x.m2 + delta*delta*(count*(x.count/n));
+		sum += x.sum;
+		min = std::min(min, x.min);
+		max = std::max(max, x.max);
+		count += x.count;
+	}
+
+};
+
+struct stats_options_t {
+	int axis = -1;                 //< also compute statistics per index of this axis, -1 for none
+	uint32_t bins = 0;             //< number of histogram bins, 0 disable the histogram
+	double range_min = numeric_limits<double>::quiet_NaN(); //< histogram range, data range if NaN
+	double range_max = numeric_limits<double>::quiet_NaN();
+	bool parallel = true;
+};
+
+struct dataset_stats_t {
+	stats_accumulator_t total;
+	int axis;
+	vector<stats_accumulator_t> per_axis;
+	double range_min;              //< range of the histogram bins, the last bin include range_max
+	double range_max;
+};
+
 template <typename _base_type>
 struct unsigned_with_undef {
 	using base_type = _base_type;
@@ -196,12 +312,17 @@ struct object_datalayout_t {
 	max_length_type   contiguous_data_size;
 
 	// CHUNKED LAYOUT
-	uint8_t           chunk_flags;
+	uint8_t           chunk_flags;                 //< only in version 4
 	uint8_t           chunk_dimensionality;        //< same as dataspace.rank+1
 	uint8_t           chunk_indexing_type;
 	vector<uint32_t>  chunk_shape;                 //< include element spacing
 	uint32_t          chunk_size_of_element;       //< same as datatype.size_of_elements
 
+	enum chunk_flags_e : uint8_t {
+		CHUNK_FLAG_DONT_FILTER_PARTIAL_BOUND_CHUNKS = 0x1u,
+		CHUNK_FLAG_SINGLE_INDEX_WITH_FILTER         = 0x2u
+	};
+
 	enum chunk_indexing_type_e : uint8_t {
 		CHUNK_INDEXING_BTREE_V1          = 0u,
 		CHUNK_INDEXING_SINGLE_CHUNK      = 1u,
@@ -278,6 +399,17 @@ struct object_datatype_t {
 		CLASS_ARRAY                  = 10u
 	};
 
+	// encoding of numbers, for enumerated it is the encoding of the base type.
+	struct number_encoding_t {
+		bool valid = false;      //< false if elements are not numbers that can be converted
+		bool floating = false;   //< IEEE floating-point, fixed-point otherwise
+		bool is_signed = false;
+		bool big_endian = false;
+		uint32_t size = 0;
+	};
+
+	number_encoding_t number;
+
 	friend ostream & operator<<(ostream & o, object_datatype_t const & datatype);
 
 };
@@ -375,6 +507,43 @@ struct object_modification_time_t {
 
 };
 
+// Messages of an object header, decoded once when the object is loaded.
+struct object_metadata_t {
+	bool has_dataspace = false;
+	bool has_datatype = false;
+	bool has_datalayout = false;
+	bool has_fillvalue_old = false;
+	bool has_fillvalue = false;
+	bool has_symbol_table = false;
+	bool has_link_info = false;
+
+	object_dataspace_t dataspace;
+	object_datatype_t datatype;
+	object_datalayout_t datalayout;
+	object_fill_value_t fillvalue_old;
+	object_data_storage_fill_value_t fillvalue;
+	object_data_storage_filter_pipeline_t filter_pipeline; //< empty if the dataset is not filtered
+
+	// link table, MSG_LINK of compact groups, the link info of dense groups
+	// and the symbol table of old style groups.
+	vector<object_link_t> links;
+	object_link_info_t link_info;
+	object_symbol_table_t symbol_table;
+
+	// return the fill value of one element, nullptr if the fill value is not defined.
+	uint8_t const * fill_value() const
+	{
+		if (not has_datatype)
+			return nullptr;
+		if (has_fillvalue and fillvalue.has_fillvalue() and fillvalue.value.size() == datatype.size_of_elements)
+			return &fillvalue.value[0];
+		if (has_fillvalue_old and fillvalue_old.value.size() == datatype.size_of_elements)
+			return &fillvalue_old.value[0];
+		return nullptr;
+	}
+
+};
+
 
 struct _h5obj {
 	_h5obj() = default;
@@ -398,6 +567,19 @@ struct _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
+	// the decoded chunk cache is shared by all objects of the same file.
+	virtual void set_chunk_cache_size(uint64_t) {
+		throw EXCEPTION("Not implemented");
+	}
+
+	virtual auto chunk_cache_stats() const -> chunk_cache_stats_t {
+		throw EXCEPTION("Not implemented");
+	}
+
+	virtual auto stats(stats_options_t const &) -> dataset_stats_t {
+		throw EXCEPTION("Not implemented");
+	}
+
 	virtual void print_info() const = 0;
 
 };
@@ -412,7 +594,7 @@ public:
 	h5obj & operator=(h5obj const &) = default;
 	h5obj(shared_ptr<_h5obj> const & x) : _ptr{x} { }
 
-	h5obj(string const & filename);
+	h5obj(string const & filename, storage_backend_e backend = STORAGE_MMAP, index_mode_e index = INDEX_NONE);
 
 	virtual ~h5obj() = default;
 
@@ -467,9 +649,35 @@ public:
 		return _ptr->list_chunk();
 	}
 
+	void set_chunk_cache_size(uint64_t bytes) {
+		_ptr->set_chunk_cache_size(bytes);
+	}
+
+	auto chunk_cache_stats() const -> chunk_cache_stats_t {
+		return _ptr->chunk_cache_stats();
+	}
+
+	/**
+	 * Statistics of the whole dataset, chunks or blocks of contiguous data are
+	 * reduced in parallel without reading the dataset in memory. Elements are
+	 * converted to double, unallocated chunks count as fill values.
+	 **/
+	auto stats(stats_options_t const & options = stats_options_t{}) const -> dataset_stats_t {
+		return _ptr->stats(options);
+	}
+
+	/**
+	 * read(output, slc...) copy the selection into output. If output is a
+	 * pointer to an arithmetic type, elements are converted to this type,
+	 * raw elements are copied if output is void *.
+	 **/
 	template<typename ... ARGS>
 	void read(ARGS ... args);
 
+	// same as read, the selection is split in tiles read by the default thread pool.
+	template<typename ... ARGS>
+	void read_parallel(ARGS ... args);
+
 };
 
 } // h5ng
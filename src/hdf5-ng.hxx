@@ -18,12 +18,14 @@
 #include <cassert>
 
 #include <map>
+#include <unordered_set>
 #include <string>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
 #include <typeinfo>
 #include <vector>
+#include <array>
 #include <list>
 #include <stack>
 #include <type_traits>
@@ -34,6 +36,16 @@
 
 #include "h5ng-spec.hxx"
 #include "h5ng.hxx"
+#include "h5ng-filters.hxx"
+#include "h5ng-thread-pool.hxx"
+#include "h5ng-chunk-cache.hxx"
+#include "h5ng-chunk-index.hxx"
+#include "h5ng-object-cache.hxx"
+#include "h5ng-storage.hxx"
+#include "h5ng-convert.hxx"
+#include "h5ng-stats.hxx"
+#include "h5ng-index.hxx"
+#include "jenkins_lookup3.hxx"
 #include "exception.hxx"
 
 #define _STR(x) #x
@@ -60,6 +72,8 @@ static uint64_t const OFFSET_V3_SIZE_OF_LENGTH = 10;
 static uint64_t const OFFSET_V1_OBJECT_HEADER_VERSION = 0;
 static uint64_t const OFFSET_V2_OBJECT_HEADER_VERSION = 4;
 
+static uint64_t const DEFAULT_CHUNK_CACHE_SIZE = 64ul<<20; // 64 MiB per file
+
 enum message_typeid_e : uint16_t {
 	MSG_NIL                                = 0x0000u,
 	MSG_DATASPACE                          = 0x0001u,
@@ -159,6 +173,24 @@ static T & read_at(uint8_t * const addr)
 	return *reinterpret_cast<T*>(addr);
 }
 
+// read little endian unsigned integer of any size up to 8 bytes.
+static inline uint64_t read_uint(uint8_t const * addr, size_t size)
+{
+	uint64_t ret = 0;
+	for (size_t i = size; i-- > 0;) {
+		ret = (ret << 8) | addr[i];
+	}
+	return ret;
+}
+
+// floor(log2(n)), 0 for n = 0
+static inline unsigned log2_floor(uint64_t n)
+{
+	unsigned ret = 0;
+	while (n >>= 1) ++ret;
+	return ret;
+}
+
 template<unsigned alignement>
 uint64_t align_forward(uint64_t ptr)
 {
@@ -224,7 +256,11 @@ struct addr_reader {
 		case 8:
 			return read<uint64_t>();
 		default:
-			throw EXCEPTION("Unexpected read size");
+			if (s > 8)
+				throw EXCEPTION("Unexpected read size");
+			ret = read_uint(cur, s);
+			cur += s;
+			return ret;
 		}
 	}
 
@@ -365,11 +401,11 @@ struct object_interface : public _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual auto canonical_obj_lookup(string const & name) const -> max_offset_type {
+	virtual auto canonical_obj_lookup(string const &) const -> max_offset_type {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual auto operator[](string const & name) const -> h5obj override {
+	virtual auto operator[](string const &) const -> h5obj override {
 		throw EXCEPTION("Not implemented");
 	}
 
@@ -377,7 +413,11 @@ struct object_interface : public _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual size_t shape(int i) const override {
+	virtual size_t shape(int) const override {
+		throw EXCEPTION("Not implemented");
+	}
+
+	virtual auto metadata() const -> h5ng::object_metadata_t const & {
 		throw EXCEPTION("Not implemented");
 	}
 
@@ -405,6 +445,11 @@ struct object_interface : public _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
+	// links of a group in the order of keys(), with the address of hard links.
+	virtual void list_links(vector<h5ng::object_link_t> &) const {
+		throw EXCEPTION("Not implemented");
+	}
+
 	virtual auto list_attributes() const -> vector<string> override {
 		throw EXCEPTION("Not implemented");
 	}
@@ -423,7 +468,7 @@ struct object_interface : public _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual auto element_size() const -> uint64_t {
+	virtual auto element_size() const -> uint64_t override {
 		throw EXCEPTION("Not implemented");
 	}
 
@@ -431,7 +476,7 @@ struct object_interface : public _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual uint8_t * fill_value() const {
+	virtual uint8_t const * fill_value() const {
 		throw EXCEPTION("Not implemented");
 	}
 
@@ -443,249 +488,438 @@ struct object_interface : public _h5obj {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual uint8_t * dataset_find_chunk(uint64_t const * key) const {
+	virtual auto get_chunk_index() const -> shared_ptr<chunk_index const> {
 		throw EXCEPTION("Not implemented");
 	}
 
-	virtual vector<chunk_desc_t> list_chunk() const
-	{
+	virtual uint8_t * chunk_address(chunk_desc_t const &) const {
 		throw EXCEPTION("Not implemented");
 	}
 
-	template<int R>
-	struct iterator {
-		array<int64_t, R> shape;
-		array<int64_t, R> strides;
-		array<int64_t, R> current;
-		uint8_t * offset;
-
-        /* the begin iterator */
-		iterator(uint8_t * offset, array<int64_t, R> shape, array<int64_t, R> stride) :
-			shape{shape},
-			strides{stride},
-			current{shape},
-			offset{offset}
-		{
-
-		}
-
-		iterator(iterator const &) = default;
-
-		iterator & operator=(iterator const &) = default;
-
-		void _incr() {
-			for(size_t x = R-1; x >= 0; --x) {
-				current[x] -= 1;
-				offset += strides[x];
-				if(current[x] == 0 and x != 0) {
-					current[x] = shape[x];
-					offset -= shape[x]*strides[x];
-				} else {
-					break;
-				}
-			}
-		}
-
-		iterator& operator++() { // prefix
-			_incr();
-			return (*this);
-		}
+	virtual auto decoded_chunk_cache() const -> chunk_cache & {
+		throw EXCEPTION("Not implemented");
+	}
 
-		iterator operator++(int) { // postfix
-			iterator ret{*this};
-			_incr();
-			return ret;
-		}
+	virtual auto storage() const -> file_storage & {
+		throw EXCEPTION("Not implemented");
+	}
 
-		uint8_t * operator *() {
-			return offset;
-		}
+	virtual vector<chunk_desc_t> list_chunk() const
+	{
+		throw EXCEPTION("Not implemented");
+	}
 
-		uint8_t * operator *() const {
-			return offset;
+	// Copy count elements from src to dst, both may be strided.
+	template<typename T>
+	static void _copy_row_as(uint8_t * dst, int64_t dst_stride, uint8_t const * src, int64_t src_stride, int64_t count)
+	{
+		// typed loop, the compiler is able to vectorize it as a gather/scatter.
+		for (int64_t i = 0; i < count; ++i) {
+			*reinterpret_cast<T *>(dst + i*dst_stride) = *reinterpret_cast<T const *>(src + i*src_stride);
 		}
+	}
 
-		bool operator==(iterator const & x) const {
-			return offset == x.offset;
+	// Copy count elements, convert them with convert if not null.
+	static void _copy_row(uint8_t * dst, int64_t dst_stride, uint8_t const * src, int64_t src_stride, int64_t count, uint64_t element_size, convert_row_func convert = nullptr)
+	{
+		if (convert) {
+			convert(dst, dst_stride, src, src_stride, count);
+			return;
 		}
 
-		bool operator!=(iterator const & x) const {
-			return offset != x.offset;
+		int64_t const s = element_size;
+		if (dst_stride == s and src_stride == s) {
+			std::memcpy(dst, src, count*element_size);
+			return;
 		}
 
-		void print() {
-			for(auto x: strides) {
-				std::cout << x << " ";
-			}
-			for(auto x: current) {
-				std::cout << x << " ";
+		switch (element_size) {
+		case 1: _copy_row_as<uint8_t>(dst, dst_stride, src, src_stride, count); break;
+		case 2: _copy_row_as<uint16_t>(dst, dst_stride, src, src_stride, count); break;
+		case 4: _copy_row_as<uint32_t>(dst, dst_stride, src, src_stride, count); break;
+		case 8: _copy_row_as<uint64_t>(dst, dst_stride, src, src_stride, count); break;
+		default:
+			for (int64_t i = 0; i < count; ++i) {
+				std::memcpy(dst + i*dst_stride, src + i*src_stride, element_size);
 			}
-			std::cout << std::endl;
 		}
+	}
 
-		friend std::ostream & operator<<(std::ostream & o, iterator const & r) {
-			return o << "<iterator " << r.offset << " >";
+	/**
+	 * Copy a strided block of R dimensions, strides are in bytes.
+	 *
+	 * Dimensions that are contiguous in both source and destination are merged
+	 * before the copy, thus a full selection end up in a single memcpy. A null
+	 * source stride broadcast the source element, this is used to fill with
+	 * fill value. If convert is not null, elements are converted while copied,
+	 * element_size is the size of source elements.
+	 **/
+	template<size_t R>
+	static void _copy_block(uint8_t * dst, array<int64_t, R> const & dst_stride, uint8_t const * src, array<int64_t, R> const & src_stride, array<int64_t, R> const & count, uint64_t element_size, convert_row_func convert = nullptr)
+	{
+		// collapsed dimensions, stored from the innermost to the outermost.
+		array<int64_t, R> n, ss, ds;
+		size_t rank = 0;
+		for (size_t i = R; i-- > 0;) {
+			if (count[i] <= 0)
+				return; // empty selection
+			if (count[i] == 1)
+				continue; // does not change the offset
+			if (rank > 0 and src_stride[i] == ss[rank-1]*n[rank-1] and dst_stride[i] == ds[rank-1]*n[rank-1]) {
+				n[rank-1] *= count[i];
+			} else {
+				n[rank] = count[i];
+				ss[rank] = src_stride[i];
+				ds[rank] = dst_stride[i];
+				++rank;
+			}
 		}
 
-	};
-
-
-	template<int R>
-	struct simple_iterator {
-		array<slc, R> const slices;
-		array<uint64_t, R> current;
-
-        /* the begin iterator */
-		simple_iterator(array<slc, R> const & slices) :
-			slices{slices}
-		{
-			for(int i = 0; i < R; ++i) { current[i] = slices[i].bgn; }
+		if (rank == 0) { // only one element
+			_copy_row(dst, 0, src, 0, 1, element_size, convert);
+			return;
 		}
 
-		simple_iterator(simple_iterator const &) = default;
-		simple_iterator & operator=(simple_iterator const &) = default;
-
-		void incr() {
-			for(size_t x = R-1; x >= 0; --x) {
-				current[x] += slices[x].inc;
-				if(current[x] >= slices[x].end and x != 0) {
-					current[x] = slices[x].bgn;
-				} else {
+		array<int64_t, R> idx;
+		std::fill(idx.begin(), idx.end(), 0);
+		while (true) {
+			_copy_row(dst, ds[0], src, ss[0], n[0], element_size, convert);
+			size_t d = 1;
+			for (; d < rank; ++d) {
+				src += ss[d];
+				dst += ds[d];
+				if (++idx[d] < n[d])
 					break;
-				}
+				src -= ss[d]*n[d];
+				dst -= ds[d]*n[d];
+				idx[d] = 0;
 			}
+			if (d == rank)
+				break;
 		}
 
-		bool is_end() {
-			return current[0] >= slices[0].end;
-		}
-
-	};
+	}
 
+	// Return the number of selected element for a normalized slice.
+	static int64_t _slice_count(slc const & s)
+	{
+		if (s.inc <= 0)
+			throw EXCEPTION("Only positive slice increment are supported (%d)", s.inc);
+		if (s.end <= s.bgn)
+			return 0;
+		return ((s.end - s.bgn) - 1)/s.inc + 1;
+	}
 
+	// Fill a strided block with the fill value, use zeroed bytes if the fill value is not defined, as libhdf5.
 	template<size_t R>
-	void _read_continuous(array<slc, R> const & selection, void * output)
+	static void _fill_block(uint8_t * dst, array<int64_t, R> const & dst_stride, array<int64_t, R> const & count, uint64_t element_size, uint8_t const * fill, convert_row_func convert = nullptr)
 	{
-		// ony for continuous or compact.
-		uint64_t element_size = this->element_size();
-
-		object_dataspace_t dataspace;
-		try {
-			dataspace = this->dataspace();
-		} catch (...) {
-
-		}
+		vector<uint8_t> pattern(element_size, 0u);
+		uint8_t const * src = fill;
+		if (not src)
+			src = &pattern[0];
+		array<int64_t, R> src_stride;
+		std::fill(src_stride.begin(), src_stride.end(), 0);
+		_copy_block<R>(dst, dst_stride, src, src_stride, count, element_size, convert);
+	}
 
-		object_datalayout_t datalayout;
-		try {
-			datalayout = this->datalayout();
-		} catch (...) {
+	// approximative size in bytes of the tiles of a parallel read.
+	enum : uint64_t { PARALLEL_READ_TILE_SIZE = 1ul<<20 };
 
+	/**
+	 * Same as _copy_block, the block is split in tiles along its outermost
+	 * non trivial dimension and tiles are copied by the default thread pool.
+	 **/
+	template<size_t R>
+	static void _copy_block_parallel(uint8_t * dst, array<int64_t, R> const & dst_stride, uint8_t const * src, array<int64_t, R> const & src_stride, array<int64_t, R> const & count, uint64_t element_size, convert_row_func convert = nullptr)
+	{
+		size_t d = 0;
+		while (d < R-1 and count[d] == 1)
+			++d;
+
+		int64_t slice_size = element_size;
+		for (size_t i = d+1; i < R; ++i)
+			slice_size *= count[i];
+
+		int64_t slices_per_tile = std::max<int64_t>(1, PARALLEL_READ_TILE_SIZE/std::max<int64_t>(1, slice_size));
+		int64_t tiles = (count[d]+slices_per_tile-1)/slices_per_tile;
+		if (tiles <= 1) {
+			_copy_block<R>(dst, dst_stride, src, src_stride, count, element_size, convert);
+			return;
 		}
 
-		object_fill_value_t fillvalue_old;
-		try {
-			fillvalue_old = this->fillvalue_old();
-		} catch (...) {
-
-		}
+		default_thread_pool()->parallel_for(tiles, [&](size_t i) {
+			int64_t first = i*slices_per_tile;
+			auto tile_count = count;
+			tile_count[d] = std::min(slices_per_tile, count[d]-first);
+			_copy_block<R>(dst+first*dst_stride[d], dst_stride, src+first*src_stride[d], src_stride, tile_count, element_size, convert);
+		});
+	}
 
-		object_data_storage_fill_value_t fillvalue;
-		try {
-			fillvalue = this->fillvalue();
-		} catch (...) {
+	// metadata of the object, checked to be a dataset.
+	auto _dataset_metadata() const -> h5ng::object_metadata_t const &
+	{
+		auto const & meta = metadata();
+		if (not meta.has_dataspace or not meta.has_datatype or not meta.has_datalayout)
+			throw EXCEPTION("Object is not a dataset");
+		return meta;
+	}
 
-		}
+	template<size_t R>
+	void _read_continuous(array<slc, R> const & selection, void * output, bool parallel, convert_row_func convert, uint64_t output_element_size)
+	{
+		// ony for continuous or compact.
+		auto const & meta = _dataset_metadata();
+		uint64_t element_size = meta.datatype.size_of_elements;
+		auto const & data_shape = meta.dataspace.shape;
 
-		if (dataspace.shape.size() != R)
-			throw EXCEPTION("dataset rank (%d) does not match selection rank (%d)", dataspace.shape.size(), R);
+		if (data_shape.size() != R)
+			throw EXCEPTION("dataset rank (%d) does not match selection rank (%d)", data_shape.size(), R);
 
 		array<int64_t, R> data_stride;
 		data_stride[R-1] = element_size;
-		for(size_t i = R-1; i > 0; --i) { data_stride[i-1] = data_stride[i]*dataspace.shape[i]; }
+		for(size_t i = R-1; i > 0; --i) { data_stride[i-1] = data_stride[i]*data_shape[i]; }
 
 		array<int64_t, R> shape;
 		array<int64_t, R> stride;
-		uint8_t * offset = continuous_data();
+		uint8_t * data = continuous_data();
+		uint8_t * offset = data;
 		for(size_t i = 0; i < R; ++i) {
-			auto s = selection[i].norm_with_dims(dataspace.shape[i]);
+			auto s = selection[i].norm_with_dims(data_shape[i]);
 			offset += data_stride[i]*s.bgn;
 			stride[i] = data_stride[i]*s.inc;
-			shape[i] = ((s.end - s.bgn) - 1)/s.inc + 1;
+			shape[i] = _slice_count(s);
 		}
 
-		iterator<R> iter{offset, shape, stride};
-		iterator<R> end{offset + stride[0]*shape[0], shape, stride};
+		array<int64_t, R> output_stride;
+		output_stride[R-1] = output_element_size;
+		for(size_t i = R-1; i > 0; --i) { output_stride[i-1] = output_stride[i]*shape[i]; }
 
 		auto cursor = reinterpret_cast<uint8_t *>(output);
-		while(iter != end) {
-			std::copy(&(*iter)[0], &(*iter)[element_size], cursor);
-			cursor += element_size;
-			++iter;
+		if (data and meta.datalayout.layout_class == h5ng::object_datalayout_t::LAYOUT_CONTIGUOUS) {
+			// contiguous data are always read through the mapping, hint the range that will be touched.
+			uint64_t last = 0;
+			for(size_t i = 0; i < R; ++i) { last += stride[i]*std::max<int64_t>(0, shape[i]-1); }
+			auto & file_storage = storage();
+			file_storage.prefetch(vector<storage_extent_t>{storage_extent_t{static_cast<uint64_t>(offset-file_storage.data()), last+element_size}});
+		}
+
+		if (not data) { // data not allocated
+			_fill_block<R>(cursor, output_stride, shape, element_size, meta.fill_value(), convert);
+		} else if (parallel) {
+			_copy_block_parallel<R>(cursor, output_stride, offset, stride, shape, element_size, convert);
+		} else {
+			_copy_block<R>(cursor, output_stride, offset, stride, shape, element_size, convert);
 		}
 
 	}
 
+	// The part of a chunked read that is within one chunk.
+	template<size_t R>
+	struct _chunk_block {
+		chunk_desc_t chunk;              //< size_of_chunk is 0 if the chunk is not allocated
+		array<uint64_t, R> chunk_offset; //< coordinates of the first element of the chunk
+		array<int64_t, R> count;         //< number of element to copy in each dimension
+		array<int64_t, R> src_stride;    //< strides within the chunk
+		int64_t src_offset;              //< offset of the first element within the chunk
+		int64_t dst_offset;              //< offset of the first element within the output
+	};
 
+	/**
+	 * Compute the list of chunk that intersect the normalized selection and
+	 * lookup each of them once in the chunk index.
+	 **/
 	template<size_t R>
-	void _read_chunked(array<slc, R> selection, void * output)
+	vector<_chunk_block<R>> _plan_chunked(array<slc, R> const & selection, array<int64_t, R> const & count,
+			array<int64_t, R> const & chunk_shape, array<int64_t, R> const & output_stride, uint64_t element_size) const
 	{
-		// ony for continuous or compact.
-		uint64_t element_size = this->element_size();
+		array<int64_t, R> chunk_stride;
+		chunk_stride[R-1] = element_size;
+		for(size_t i = R-1; i > 0; --i) { chunk_stride[i-1] = chunk_shape[i]*chunk_stride[i]; }
+
+		// range of chunk index that intersect the selection
+		array<int64_t, R> first_chunk, last_chunk;
+		for(size_t i = 0; i < R; ++i) {
+			first_chunk[i] = selection[i].bgn/chunk_shape[i];
+			last_chunk[i] = (selection[i].bgn+(count[i]-1)*selection[i].inc)/chunk_shape[i];
+		}
+
+		auto index = get_chunk_index();
+
+		vector<_chunk_block<R>> ret;
+		array<int64_t, R> current{first_chunk};
+		while (true) {
+			// compute the sub-selection that is within the current chunk.
+			_chunk_block<R> block{chunk_desc_t{0u, 0u, 0u}, {}, {}, {}, 0, 0};
+			bool empty = false;
+			for(size_t i = 0; i < R; ++i) {
+				int64_t const bgn = current[i]*chunk_shape[i];
+				int64_t const end = bgn+chunk_shape[i];
+				auto const & s = selection[i];
+				int64_t k0 = (bgn > s.bgn)?(bgn - s.bgn + s.inc - 1)/s.inc:0;
+				int64_t k1 = std::min<int64_t>(count[i], (end - s.bgn + s.inc - 1)/s.inc);
+				if (k0 >= k1) {
+					empty = true;
+					break;
+				}
+				block.chunk_offset[i] = bgn;
+				block.count[i] = k1-k0;
+				block.src_stride[i] = chunk_stride[i]*s.inc;
+				block.src_offset += chunk_stride[i]*(s.bgn+k0*s.inc-bgn);
+				block.dst_offset += output_stride[i]*k0;
+			}
+
+			if (not empty) {
+				block.chunk = index->find(&block.chunk_offset[0]);
+				ret.push_back(block);
+			}
+
+			// next chunk
+			size_t d = R;
+			while (d-- > 0) {
+				if (++current[d] <= last_chunk[d])
+					break;
+				current[d] = first_chunk[d];
+			}
+			if (d == static_cast<size_t>(-1))
+				break;
+		}
+
+		return ret;
+	}
 
-		auto data_shape = shape();
+	/**
+	 * Read chunked dataset one chunk at time.
+	 *
+	 * For each chunk that intersect the selection, the chunk is looked up once,
+	 * then the intersection is copied as strided block. Chunks are fetched
+	 * through the file storage backend, that sort them by address and merge
+	 * close ones in large reads. When the dataset is filtered, chunks are
+	 * decoded in parallel using the default thread pool and kept in the file
+	 * decoded chunk cache. Unfiltered chunks are copied in parallel only if
+	 * requested.
+	 **/
+	template<size_t R>
+	void _read_chunked(array<slc, R> selection, void * output, bool parallel, convert_row_func convert, uint64_t output_element_size)
+	{
+		auto const & meta = _dataset_metadata();
+		uint64_t element_size = meta.datatype.size_of_elements;
+
+		auto const & data_shape = meta.dataspace.shape;
 		if (data_shape.size() != R)
 			throw EXCEPTION("dataset rank (%d) does not match selection rank (%d)", data_shape.size(), R);
 
-		auto chunk_shape = shape_of_chunk();
+		// the last dimension of the chunk shape is the element size.
+		array<int64_t, R> chunk_shape;
+		auto const & _chunk_shape = meta.datalayout.chunk_shape;
+		if (meta.datalayout.layout_class != h5ng::object_datalayout_t::LAYOUT_CHUNKED)
+			throw EXCEPTION("Dataset is not chunked");
+		if (_chunk_shape.size() != R+1)
+			throw EXCEPTION("chunk rank (%d) does not match selection rank (%d)", _chunk_shape.size()-1, R);
+		std::copy(_chunk_shape.begin(), _chunk_shape.begin()+R, chunk_shape.begin());
 
 		// normalize
+		array<int64_t, R> count;
 		for(size_t i = 0; i < R; ++i) {
 			selection[i] = selection[i].norm_with_dims(data_shape[i]);
+			count[i] = _slice_count(selection[i]);
+			if (count[i] == 0)
+				return;
 		}
 
-		array<uint64_t, R> chunk_stride;
-		chunk_stride[R-1] = element_size;
-		for(size_t i = R-1; i > 0; --i) { chunk_stride[i-1] = chunk_shape[i]*chunk_stride[i]; }
+		array<int64_t, R> output_stride;
+		output_stride[R-1] = output_element_size;
+		for(size_t i = R-1; i > 0; --i) { output_stride[i-1] = output_stride[i]*count[i]; }
+
+		auto blocks = _plan_chunked<R>(selection, count, chunk_shape, output_stride, element_size);
 
 		auto cursor = reinterpret_cast<uint8_t *>(output);
-		for(simple_iterator<R> iter{selection}; not iter.is_end(); iter.incr()) {
-			array<uint64_t, R> chunk_offset;
-			for(size_t i = 0; i < R; ++i) { chunk_offset[i] = iter.current[i] - iter.current[i]%chunk_shape[i]; }
-
-			uint8_t * chunk = dataset_find_chunk(&chunk_offset[0]);
-			if (chunk) {
-				for(size_t i = 0; i < R; ++i) {
-					chunk += chunk_stride[i]*(iter.current[i]-chunk_offset[i]);
-				}
-				std::copy(&chunk[0], &chunk[element_size], cursor);
-			} else {
-				if (fill_value()) {
-					uint8_t * x = fill_value();
-					std::copy(&x[0], &x[element_size], cursor);
-				} else {
-					std::fill(&cursor[0], &cursor[element_size], -1);
+		uint8_t const * fill = meta.fill_value();
+		auto const & pipeline = meta.filter_pipeline;
+		bool const filtered = not pipeline.filters.empty();
+		bool const threaded = parallel or filtered;
+
+		uint64_t chunk_size = element_size;
+		for (auto x: chunk_shape) { chunk_size *= x; }
+
+		auto & cache = decoded_chunk_cache();
+		uint64_t id = get_id();
+
+		// fill unallocated chunks and copy cached chunks, other are fetched.
+		vector<char> to_fetch(blocks.size(), false);
+		auto local = [&](size_t i) {
+			auto const & block = blocks[i];
+			if (block.chunk.size_of_chunk == 0) {
+				_fill_block<R>(cursor+block.dst_offset, output_stride, block.count, element_size, fill, convert);
+				return;
+			}
+
+			if (filtered) {
+				auto data = cache.find(id, &block.chunk_offset[0], R);
+				if (data) {
+					_copy_block<R>(cursor+block.dst_offset, output_stride, &(*data)[0]+block.src_offset, block.src_stride, block.count, element_size, convert);
+					return;
 				}
 			}
-			cursor += element_size;
+
+			to_fetch[i] = true;
+		};
+
+		if (threaded) {
+			default_thread_pool()->parallel_for(blocks.size(), local);
+		} else {
+			for (size_t i = 0; i < blocks.size(); ++i)
+				local(i);
+		}
+
+		vector<size_t> fetched;
+		vector<storage_extent_t> extents;
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			if (not to_fetch[i])
+				continue;
+			fetched.push_back(i);
+			extents.push_back(storage_extent_t{blocks[i].chunk.address, blocks[i].chunk.size_of_chunk});
 		}
 
+		storage().fetch(extents, threaded, [&](size_t k, uint8_t const * chunk) {
+			auto const & block = blocks[fetched[k]];
+			if (not filtered) {
+				_copy_block<R>(cursor+block.dst_offset, output_stride, chunk+block.src_offset, block.src_stride, block.count, element_size, convert);
+				return;
+			}
+
+			// scratch buffer is kept per thread to avoid allocation for each chunk.
+			thread_local vector<uint8_t> tmp;
+			auto decoded = make_shared<vector<uint8_t>>();
+			filter_pipeline_decode(pipeline, block.chunk.filters, chunk, block.chunk.size_of_chunk, *decoded, tmp, chunk_size);
+			cache.insert(id, &block.chunk_offset[0], R, decoded);
+			_copy_block<R>(cursor+block.dst_offset, output_stride, &(*decoded)[0]+block.src_offset, block.src_stride, block.count, element_size, convert);
+		});
+
 	}
 
 
+	/**
+	 * Read the selection into output. If convert is not null, elements are
+	 * converted while copied and output elements are output_element_size
+	 * bytes, otherwise raw elements are copied.
+	 **/
 	template<size_t R>
-	void _read(array<slc, R> const & selection, void * output)
+	void _read(array<slc, R> const & selection, void * output, bool parallel = false, convert_row_func convert = nullptr, uint64_t output_element_size = 0)
 	{
-		switch(data_layout()) {
+		auto const & meta = _dataset_metadata();
+		if (not convert)
+			output_element_size = meta.datatype.size_of_elements;
+
+		switch(meta.datalayout.layout_class) {
 		case 0: // compact
-			_read_continuous(selection, output);
+			_read_continuous(selection, output, false, convert, output_element_size);
 			break;
 		case 1: // continuous
-			_read_continuous(selection, output);
+			_read_continuous(selection, output, parallel, convert, output_element_size);
 			break;
 		case 2: // chunked
-			// TODO
-			_read_chunked(selection, output);
+			_read_chunked(selection, output, parallel, convert, output_element_size);
 			break;
 		case 3: // virtual
 			// TODO
@@ -697,19 +931,306 @@ struct object_interface : public _h5obj {
 
 	}
 
+	/**
+	 * Read the element of a scalar dataset, a selection of rank 0 is only
+	 * valid for them. Scalar datasets are compact or continuous.
+	 **/
+	void _read(array<slc, 0> const &, void * output, bool = false, convert_row_func convert = nullptr, uint64_t = 0)
+	{
+		auto const & meta = _dataset_metadata();
+		if (meta.dataspace.shape.size() != 0)
+			throw EXCEPTION("dataset rank (%d) does not match selection rank (0)", meta.dataspace.shape.size());
+		if (meta.datalayout.layout_class != 0 and meta.datalayout.layout_class != 1)
+			throw EXCEPTION("Unsupported data layout (%d) for a scalar dataset", meta.datalayout.layout_class);
+
+		uint64_t element_size = meta.datatype.size_of_elements;
+		array<int64_t, 1> const stride{0};
+		array<int64_t, 1> const count{1};
+		auto cursor = reinterpret_cast<uint8_t *>(output);
+		uint8_t * data = continuous_data();
+		if (not data) { // data not allocated
+			_fill_block<1>(cursor, stride, count, element_size, meta.fill_value(), convert);
+		} else {
+			_copy_block<1>(cursor, stride, data, stride, count, element_size, convert);
+		}
+	}
+
 	template<typename ... ARGS>
 	struct _dispatch_read;
 
 	template<typename ... ARGS>
 	struct _dispatch_read<void *, ARGS...> {
-		static void exec(object_interface * obj, void * output, ARGS ... args) {
-			obj->_read(array<slc, sizeof...(ARGS)>{slc{args}...}, output);
+		static void exec(object_interface * obj, bool parallel, void * output, ARGS ... args) {
+			obj->_read(array<slc, sizeof...(ARGS)>{slc{args}...}, output, parallel);
+		}
+	};
+
+	// typed output, elements are converted to T.
+	template<typename T, typename ... ARGS>
+	struct _dispatch_read<T *, ARGS...> {
+		static void exec(object_interface * obj, bool parallel, T * output, ARGS ... args) {
+			auto convert = select_convert<T>(obj->_dataset_metadata().datatype);
+			obj->_read(array<slc, sizeof...(ARGS)>{slc{args}...}, output, parallel, convert, sizeof(T));
 		}
 	};
 
 	template<typename ... ARGS>
 	void _read_0(ARGS ... args) {
-		_dispatch_read<ARGS...>::exec(this, args...);
+		_dispatch_read<ARGS...>::exec(this, false, args...);
+	}
+
+	template<typename ... ARGS>
+	void _read_parallel_0(ARGS ... args) {
+		_dispatch_read<ARGS...>::exec(this, true, args...);
+	}
+
+	// chunks fetched at once, bound the size of fetch plans.
+	enum : uint64_t { STATS_BATCH_SIZE = 4096 };
+	// elements converted at once, the buffer stays in cache.
+	enum : uint64_t { STATS_RUN_SIZE = 4096 };
+	// approximative size of the blocks of contiguous data reduced at once.
+	enum : uint64_t { STATS_BLOCK_SIZE = 8ul<<20 };
+
+	struct _stats_state {
+		stats_bins_t bins;
+		int axis;
+		mutex lock;
+		stats_accumulator_t total;
+		vector<stats_accumulator_t> per_axis;
+	};
+
+	/**
+	 * Reduce a block of elements stored with the given shape, count is the
+	 * part of the block within the dataset and offset its position in the
+	 * dataset. The block is reduced in local accumulators, then merged.
+	 **/
+	static void _stats_reduce_block(_stats_state & state, uint8_t const * src, vector<uint64_t> const & shape,
+			vector<uint64_t> const & count, vector<uint64_t> const & offset, uint64_t element_size, convert_row_func convert)
+	{
+		size_t const R = shape.size();
+		for (auto x: count) {
+			if (x == 0)
+				return;
+		}
+
+		vector<uint64_t> stride(R);
+		stride[R-1] = element_size;
+		for (size_t d = R-1; d > 0; --d)
+			stride[d-1] = stride[d]*shape[d];
+
+		thread_local vector<double> buffer;
+		buffer.resize(STATS_RUN_SIZE);
+
+		int const axis = state.axis;
+		stats_accumulator_t total;
+		vector<stats_accumulator_t> per_axis(axis >= 0 ? count[axis] : 0);
+
+		// rows along the last dimension are reduced as runs.
+		vector<uint64_t> idx(R, 0);
+		uint64_t const run = count[R-1];
+		bool more = true;
+		while (more) {
+			uint8_t const * row = src;
+			for (size_t d = 0; d+1 < R; ++d)
+				row += idx[d]*stride[d];
+
+			for (uint64_t j = 0; j < run; j += STATS_RUN_SIZE) {
+				uint64_t n = std::min<uint64_t>(STATS_RUN_SIZE, run-j);
+				double const * x = reinterpret_cast<double const *>(row+j*element_size);
+				if (convert) {
+					convert(reinterpret_cast<uint8_t *>(&buffer[0]), sizeof(double), row+j*element_size, element_size, n);
+					x = &buffer[0];
+				}
+
+				stats_reduce(total, state.bins, x, n);
+				if (axis == static_cast<int>(R-1)) {
+					for (uint64_t k = 0; k < n; ++k)
+						stats_add_repeated(per_axis[j+k], state.bins, x[k], 1);
+				} else if (axis >= 0) {
+					stats_reduce(per_axis[idx[axis]], state.bins, x, n);
+				}
+			}
+
+			more = false;
+			for (size_t d = R-1; d-- > 0;) {
+				if (++idx[d] < count[d]) {
+					more = true;
+					break;
+				}
+				idx[d] = 0;
+			}
+		}
+
+		unique_lock<mutex> l{state.lock};
+		state.total.merge(total);
+		for (size_t i = 0; i < per_axis.size(); ++i)
+			state.per_axis[offset[axis]+i].merge(per_axis[i]);
+	}
+
+	/**
+	 * Reduce all allocated elements of the dataset. Chunks are visited in
+	 * grid order by batches, each batch is fetched through the file storage
+	 * and chunks are decoded and reduced as they arrive. Contiguous data are
+	 * split in blocks of rows.
+	 **/
+	void _stats_pass(_stats_state & state, bool parallel)
+	{
+		auto const & meta = _dataset_metadata();
+		uint64_t element_size = meta.datatype.size_of_elements;
+		vector<uint64_t> shape{meta.dataspace.shape.begin(), meta.dataspace.shape.end()};
+		if (shape.empty())
+			shape.push_back(1); // scalar
+		size_t const R = shape.size();
+
+		auto convert = select_convert<double>(meta.datatype);
+
+		if (meta.datalayout.layout_class == h5ng::object_datalayout_t::LAYOUT_CHUNKED) {
+			auto index = get_chunk_index();
+			auto const & chunk_shape = index->chunk_shape();
+			uint64_t chunk_size = element_size;
+			for (auto x: chunk_shape)
+				chunk_size *= x;
+
+			auto const & pipeline = meta.filter_pipeline;
+			bool const filtered = not pipeline.filters.empty();
+
+			vector<vector<uint64_t>> offsets;
+			vector<uint32_t> filters;
+			vector<storage_extent_t> extents;
+			auto reduce_batch = [&]() {
+				storage().fetch(extents, parallel, [&](size_t k, uint8_t const * chunk) {
+					auto const & offset = offsets[k];
+					vector<uint64_t> count(R);
+					for (size_t d = 0; d < R; ++d)
+						count[d] = std::min(chunk_shape[d], shape[d]-offset[d]);
+
+					uint8_t const * src = chunk;
+					if (filtered) {
+						thread_local vector<uint8_t> decoded;
+						thread_local vector<uint8_t> tmp;
+						filter_pipeline_decode(pipeline, filters[k], chunk, extents[k].size, decoded, tmp, chunk_size);
+						src = &decoded[0];
+					}
+
+					_stats_reduce_block(state, src, chunk_shape, count, offset, element_size, convert);
+				});
+				offsets.clear();
+				filters.clear();
+				extents.clear();
+			};
+
+			index->for_each([&](uint64_t const * scaled, chunk_desc_t const & chunk) {
+				vector<uint64_t> offset(R);
+				for (size_t d = 0; d < R; ++d)
+					offset[d] = scaled[d]*chunk_shape[d];
+				offsets.push_back(std::move(offset));
+				filters.push_back(chunk.filters);
+				extents.push_back(storage_extent_t{chunk.address, chunk.size_of_chunk});
+				if (extents.size() == STATS_BATCH_SIZE)
+					reduce_batch();
+			});
+			reduce_batch();
+			return;
+		}
+
+		uint8_t const * data = continuous_data();
+		if (not data) // not allocated, only fill values
+			return;
+
+		uint64_t row_size = element_size;
+		for (size_t d = 1; d < R; ++d)
+			row_size *= shape[d];
+
+		uint64_t rows = std::max<uint64_t>(1, STATS_BLOCK_SIZE/std::max<uint64_t>(1, row_size));
+		uint64_t blocks = (shape[0]+rows-1)/rows;
+		bool const mapped = meta.datalayout.layout_class == h5ng::object_datalayout_t::LAYOUT_CONTIGUOUS;
+
+		for (uint64_t first = 0; first < blocks; first += STATS_BATCH_SIZE) {
+			uint64_t last = std::min<uint64_t>(blocks, first+STATS_BATCH_SIZE);
+			if (mapped) {
+				auto & file_storage = storage();
+				uint64_t bgn = first*rows*row_size;
+				uint64_t end = std::min(last*rows, shape[0])*row_size;
+				file_storage.prefetch(vector<storage_extent_t>{storage_extent_t{static_cast<uint64_t>(data-file_storage.data())+bgn, end-bgn}});
+			}
+
+			auto reduce = [&](size_t i) {
+				uint64_t b = first+i;
+				vector<uint64_t> block_shape{shape};
+				block_shape[0] = rows;
+				vector<uint64_t> count{shape};
+				count[0] = std::min(rows, shape[0]-b*rows);
+				vector<uint64_t> offset(R, 0);
+				offset[0] = b*rows;
+				_stats_reduce_block(state, data+b*rows*row_size, block_shape, count, offset, element_size, convert);
+			};
+
+			if (parallel) {
+				default_thread_pool()->parallel_for(last-first, reduce);
+			} else {
+				for (size_t i = 0; i < last-first; ++i)
+					reduce(i);
+			}
+		}
+	}
+
+	virtual auto stats(stats_options_t const & options) -> dataset_stats_t override
+	{
+		auto const & meta = _dataset_metadata();
+		vector<uint64_t> shape{meta.dataspace.shape.begin(), meta.dataspace.shape.end()};
+		if (shape.empty())
+			shape.push_back(1); // scalar
+		if (options.axis >= static_cast<int>(shape.size()))
+			throw EXCEPTION("Invalid axis (%d) for dataset of rank %d", options.axis, shape.size());
+
+		uint64_t elements = 1;
+		for (auto x: shape)
+			elements *= x;
+
+		// unallocated elements are fill values.
+		double fill;
+		uint64_t element_size = meta.datatype.size_of_elements;
+		auto convert = select_convert<double>(meta.datatype);
+		_fill_block<1>(reinterpret_cast<uint8_t *>(&fill), array<int64_t, 1>{sizeof(double)}, array<int64_t, 1>{1}, element_size, meta.fill_value(), convert);
+
+		dataset_stats_t ret;
+		ret.axis = options.axis;
+		ret.range_min = options.range_min;
+		ret.range_max = options.range_max;
+
+		// without range the histogram need a first pass to find it.
+		if (options.bins > 0 and (std::isnan(ret.range_min) or std::isnan(ret.range_max))) {
+			_stats_state range;
+			range.axis = -1;
+			_stats_pass(range, options.parallel);
+			stats_add_repeated(range.total, range.bins, fill, elements-range.total.count-range.total.nan_count);
+			if (std::isnan(ret.range_min))
+				ret.range_min = range.total.count > 0 ? range.total.min : 0.0;
+			if (std::isnan(ret.range_max))
+				ret.range_max = range.total.count > 0 ? range.total.max : 0.0;
+		}
+
+		_stats_state state;
+		state.axis = options.axis;
+		if (options.bins > 0)
+			state.bins = stats_bins_t{options.bins, ret.range_min, ret.range_max};
+		if (options.axis >= 0)
+			state.per_axis.resize(shape[options.axis]);
+
+		_stats_pass(state, options.parallel);
+
+		stats_add_repeated(state.total, state.bins, fill, elements-state.total.count-state.total.nan_count);
+		for (auto & x: state.per_axis)
+			stats_add_repeated(x, state.bins, fill, elements/shape[options.axis]-x.count-x.nan_count);
+		if (options.bins > 0) {
+			state.total.histogram.resize(options.bins, 0);
+			for (auto & x: state.per_axis)
+				x.histogram.resize(options.bins, 0);
+		}
+
+		ret.total = std::move(state.total);
+		ret.per_axis = std::move(state.per_axis);
+		return ret;
 	}
 
 };
@@ -722,6 +1243,11 @@ struct file_handler_interface {
 	virtual auto make_superblock(max_offset_type offset) -> shared_ptr<superblock_interface> = 0;
 	virtual auto make_object(max_offset_type offset) -> shared_ptr<object_interface> = 0;
 
+	virtual auto get_chunk_cache() -> chunk_cache & = 0;
+
+	// objects found in index are loaded without parsing their header.
+	virtual void set_index(shared_ptr<metadata_index const> const & index) = 0;
+
 };
 
 
@@ -760,20 +1286,37 @@ static uint64_t get_minimum_storage_size_for(uint64_t count) {
 }
 
 struct file_handler_t : public h5ng::file_handler_interface {
-	mutable map<max_offset_type::base_type, shared_ptr<superblock_interface>> superblock_cache;
-	mutable map<max_offset_type::base_type, shared_ptr<object_interface>> object_cache;
-	mutable map<string, shared_ptr<object_interface>> external_file_cache;
+	// caches are shared by all threads reading the file.
+	mutable h5ng::object_cache<max_offset_type::base_type, superblock_interface> superblock_cache;
+	mutable h5ng::object_cache<max_offset_type::base_type, object_interface> object_cache;
+	mutable h5ng::object_cache<string, object_interface> external_file_cache;
+
+	// resolved paths of more than one component, keyed by the id of the
+	// object where the lookup start and the normalized path.
+	using path_key = pair<uint64_t, string>;
+	struct path_key_hash {
+		size_t operator()(path_key const & k) const
+		{
+			return std::hash<string>{}(k.second) ^ (k.first*0x9e3779b97f4a7c15ul);
+		}
+	};
+	mutable h5ng::object_cache<path_key, object_interface, path_key_hash> path_cache;
+	mutable chunk_cache decoded_chunk_cache; //< shared by all datasets of the file
+	shared_ptr<metadata_index const> index;  //< sidecar index, null if not used
 
 	string const abs_filename; //< store the absolute filename, this is require to handle external link
 
+	shared_ptr<file_storage> storage; //< own the file mapping
 	uint8_t * memaddr;
 
 	int version;
 	uint64_t superblock_offset;
 
-	file_handler_t(string const & abs_filename, uint8_t * memaddr, uint64_t superblock_offset, int version) :
+	file_handler_t(string const & abs_filename, shared_ptr<file_storage> const & storage, uint64_t superblock_offset, int version) :
+		decoded_chunk_cache{DEFAULT_CHUNK_CACHE_SIZE},
 		abs_filename{abs_filename},
-		memaddr{memaddr},
+		storage{storage},
+		memaddr{storage->data()},
 		version{version},
 		superblock_offset{superblock_offset}
 	{
@@ -809,6 +1352,16 @@ struct file_handler_t : public h5ng::file_handler_interface {
 	virtual auto make_superblock(max_offset_type offset) -> shared_ptr<superblock_interface> override;
 	virtual auto make_object(max_offset_type offset) -> shared_ptr<object_interface> override;
 
+	virtual auto get_chunk_cache() -> chunk_cache & override
+	{
+		return decoded_chunk_cache;
+	}
+
+	virtual void set_index(shared_ptr<metadata_index const> const & index) override
+	{
+		this->index = index;
+	}
+
 };
 
 struct object {
@@ -1447,8 +2000,8 @@ struct group_symbol_table {
 		return spec::number_of_symbols::get(addr);
 	}
 
-	group_symbol_table_entry get_symbol_table_entry(int i) {
-		return group_symbol_table_entry{addr + spec::size + i * spec_defs::group_symbol_table_entry_spec::size};
+	group_symbol_table_entry * get_symbol_table_entry(int i) {
+		return reinterpret_cast<group_symbol_table_entry*>(addr + spec::size + i * spec_defs::group_symbol_table_entry_spec::size);
 	}
 
 	using symbol_table_entry_list = raw_entry_list<group_symbol_table_entry, spec_defs::group_symbol_table_entry_spec::size>;
@@ -1582,6 +2135,13 @@ struct object_symbol_table_t : public h5ng::object_symbol_table_t {
 		group_btree_v1_root = spec_defs::message_symbole_table_spec::b_tree_v1_address::get(msg);
 	}
 
+	// Create the symbole table from already decoded message.
+	object_symbol_table_t(file_handler_t * file, h5ng::object_symbol_table_t const & x) :
+		h5ng::object_symbol_table_t{x}, file{file}
+	{
+
+	}
+
 	char const * _get_link_name(uint64_t offset) const {
 		local_heap_v0 h{file, file->to_address(local_heap)};
 		return reinterpret_cast<char *>(h.get_data(offset));
@@ -1594,23 +2154,45 @@ struct object_symbol_table_t : public h5ng::object_symbol_table_t {
 
 	offset_type operator[](char const * key) const
 	{
-		auto group_symbol_table_offset = _group_find_symbol_table(key);
+		offset_type offset = find(key);
+		if (offset == undef_offset)
+			throw EXCEPTION("key `%s' not found", key);
+		return offset;
+	}
+
+	// return the object header address of key or undef_offset if not found.
+	offset_type find(char const * key) const
+	{
+		offset_type group_symbol_table_offset;
+		if (not _group_find_symbol_table(key, group_symbol_table_offset))
+			return undef_offset;
+
+		// Entries of a symbol table node are kept sorted by name.
 		group_symbol_table table{file->to_address(group_symbol_table_offset)};
-		// It's not specified that entry in symbol_table are sorted, thus we must lookup all entry.
-		for(auto symbol_table_entry: table.get_symbole_entry_list()) {
-			char const * link_name = _get_link_name(symbol_table_entry->link_name_offset());
-			if (std::strcmp(key, link_name) == 0)
+		size_t lo = 0;
+		size_t hi = table.number_of_symbols();
+		while (lo < hi) {
+			size_t mi = (lo + hi)/2;
+			auto symbol_table_entry = table.get_symbol_table_entry(mi);
+			int c = std::strcmp(key, _get_link_name(symbol_table_entry->link_name_offset()));
+			if (c == 0)
 				return symbol_table_entry->offset_header_address();
+			if (c < 0) {
+				hi = mi;
+			} else {
+				lo = mi+1;
+			}
 		}
 
-		throw EXCEPTION("key `%s' not found", key);
+		return undef_offset;
 
 	}
 
 	/**
 	 * lookup through the b-tree table to find the index of the next b-tree node.
+	 * @return false if the key is out of the node range.
 	 **/
-	size_t _group_find_symbol_table_index(group_btree_v1 const & cur, char const * key) const
+	bool _group_find_symbol_table_index(group_btree_v1 const & cur, char const * key, size_t & index) const
 	{
 		size_t lo = 0;
 		size_t hi = cur.get_entries_count();
@@ -1618,14 +2200,14 @@ struct object_symbol_table_t : public h5ng::object_symbol_table_t {
 		{ // sanity check
 			char const * link_name = _get_link_name(cur.get_key(SIZE_OF_LENGTH, lo));
 			if (std::strcmp(key, link_name) <= 0) {
-				throw EXCEPTION("Key `%s' not found", key);
+				return false;
 			}
 		}
 
 		{ // sanity check
 			char const * link_name = _get_link_name(cur.get_key(SIZE_OF_LENGTH, hi));
 			if (not (std::strcmp(key, link_name) <= 0)) {
-				throw EXCEPTION("Key `%s' not found", key);
+				return false;
 			}
 		}
 
@@ -1639,25 +2221,32 @@ struct object_symbol_table_t : public h5ng::object_symbol_table_t {
 			}
 		}
 
-		return lo;
+		index = lo;
+		return true;
 
 	}
 
-	/** return group_symbole_table that should content the key **/
-	offset_type _group_find_symbol_table(char const * key) const {
+	/** find the group_symbole_table that should content the key, false if none **/
+	bool _group_find_symbol_table(char const * key, offset_type & offset) const {
 		group_btree_v1 cur{file->to_address(group_btree_v1_root)};
 
+		size_t i;
 		while(cur.get_depth() != 0) {
-			size_t i = _group_find_symbol_table_index(cur, key);
+			if (not _group_find_symbol_table_index(cur, key, i))
+				return false;
 			cur = group_btree_v1{file->to_address(cur.get_node(SIZE_OF_LENGTH, i))};
 		}
 
-		size_t i = _group_find_symbol_table_index(cur, key);
-		return cur.get_node(SIZE_OF_LENGTH, i);
+		if (not _group_find_symbol_table_index(cur, key, i))
+			return false;
+		offset = cur.get_node(SIZE_OF_LENGTH, i);
+		return true;
 
 	}
 
-	void ls(vector<string> & ret) const
+	// call func(entry) for each entry of the symbol table.
+	template<typename F>
+	void _for_each_entry(F && func) const
 	{
 		stack<group_btree_v1> stack;
 
@@ -1682,12 +2271,28 @@ struct object_symbol_table_t : public h5ng::object_symbol_table_t {
 		for(auto offset: group_symbole_tables) {
 			group_symbol_table table{file->to_address(offset)};
 			for(auto symbol_table_entry: table.get_symbole_entry_list()) {
-				ret.push_back(_get_link_name(symbol_table_entry->link_name_offset()));
+				func(symbol_table_entry);
 			}
 		}
 
 	}
 
+	void ls(vector<string> & ret) const
+	{
+		_for_each_entry([&](group_symbol_table_entry * entry) {
+			ret.push_back(_get_link_name(entry->link_name_offset()));
+		});
+	}
+
+	// same as ls with the address of objects.
+	void list(vector<h5ng::object_link_t> & ret) const
+	{
+		_for_each_entry([&](group_symbol_table_entry * entry) {
+			max_offset_type offset = entry->offset_header_address();
+			ret.push_back(h5ng::object_link_t{0u, _get_link_name(entry->link_name_offset()), offset, string{}});
+		});
+	}
+
 
 	vector<string> ls() const
 	{
@@ -1765,7 +2370,7 @@ struct object_dataspace_t : public h5ng::object_dataspace_t {
 				max_shape = vector<uint64_t>{&max_shape_ptr[0], &max_shape_ptr[rank]};
 				cur += rank*SIZE_OF_LENGTH;
 			} else {
-				max_shape = vector<uint64_t>(rank, numeric_limits<uint64_t>::max());
+				max_shape = shape; // maximum is the current size when not stored.
 			}
 
 			if (flags.test(1)) {
@@ -1791,7 +2396,7 @@ struct object_dataspace_t : public h5ng::object_dataspace_t {
 				max_shape = vector<uint64_t>{&max_shape_ptr[0], &max_shape_ptr[rank]};
 				cur += rank*SIZE_OF_LENGTH;
 			} else {
-				max_shape = vector<uint64_t>(rank, numeric_limits<uint64_t>::max());
+				max_shape = shape; // maximum is the current size when not stored.
 			}
 
 			// in version 2 permutation is removed, because it was never implemented.
@@ -1806,16 +2411,367 @@ struct object_dataspace_t : public h5ng::object_dataspace_t {
 
 };
 
-struct object_datalayout_t : public h5ng::object_datalayout_t {
-	file_handler_t * file;
+// Fixed array, used to index chunks of dataset without unlimited dimension.
+struct fixed_array {
+	using spec = typename spec_defs::fixed_array_hdr_spec;
+	using dblock_spec = typename spec_defs::fixed_array_data_block_spec;
 
-	object_datalayout_t(file_handler_t * file, uint8_t * msg) : file{file}
+	file_handler_t * file;
+	uint8_t * memory_addr;
+	uint8_t * data;           //< first element or first page, nullptr if not allocated
+	uint8_t * page_init;      //< page bitmap, nullptr if the array is not paged
+	uint64_t entry_size;
+	uint64_t count;
+	uint64_t page_nelmts;
+
+	fixed_array(file_handler_t * file, uint8_t * addr) :
+		file{file}, memory_addr{addr}, data{nullptr}, page_init{nullptr}
 	{
-	//		cout << "parse_datalayout " << std::dec <<
-	//				" version=" << static_cast<unsigned>(spec_defs::message_data_layout_v1_spec::version::get(msg)) <<
-	//				endl;
+		if (std::memcmp(spec::signature::get(memory_addr), "FAHD", 4) != 0)
+			throw EXCEPTION("Invalid fixed array header signature");
 
-		version = spec_defs::message_data_layout_v1_spec::version::get(msg);
+		entry_size = spec::entry_size::get(memory_addr);
+		count = spec::max_num_entries::get(memory_addr);
+		page_nelmts = 1ul << spec::page_bits::get(memory_addr);
+
+		uint64_t dblock_address = spec::data_block_address::get(memory_addr);
+		if (dblock_address == static_cast<uint64_t>(undef_offset))
+			return;
+
+		uint8_t * dblock = file->to_address(dblock_address);
+		if (std::memcmp(dblock_spec::signature::get(dblock), "FADB", 4) != 0)
+			throw EXCEPTION("Invalid fixed array data block signature");
+
+		data = dblock + dblock_spec::size;
+		if (count > page_nelmts) {
+			// pages come after the page bitmap and the data block checksum.
+			page_init = data;
+			data += (((count+page_nelmts-1)/page_nelmts)+7)/8 + 4;
+		}
+	}
+
+	bool client_is_filtered_chunk() const
+	{
+		return spec::client_id::get(memory_addr) == 1;
+	}
+
+	// return the element idx, nullptr if its page is not initialized.
+	uint8_t * get_element(uint64_t idx) const
+	{
+		if (not data or idx >= count)
+			return nullptr;
+		if (not page_init)
+			return data + idx*entry_size;
+		uint64_t page_idx = idx/page_nelmts;
+		if (not (page_init[page_idx/8] & (0x80u >> (page_idx%8))))
+			return nullptr;
+		return data + page_idx*(page_nelmts*entry_size+4) + (idx%page_nelmts)*entry_size;
+	}
+
+};
+
+// Extensible array, used to index chunks of dataset with one unlimited dimension.
+struct extensible_array {
+	using spec = typename spec_defs::extensible_array_hdr_spec;
+	using block_spec = typename spec_defs::extensible_array_block_spec;
+
+	struct super_block_info_t {
+		uint64_t ndblks;          //< number of data blocks in the super block
+		uint64_t dblk_nelmts;     //< number of elements per data block
+		uint64_t start_idx;       //< first element index of the super block
+		uint64_t start_dblk;      //< first data block index of the super block
+	};
+
+	file_handler_t * file;
+	uint8_t * memory_addr;
+	uint8_t * iblock;         //< index block, nullptr if not allocated
+	uint64_t element_size;
+	uint64_t arr_off_size;    //< size of the block offset field in secondary and data blocks
+	uint64_t iblock_nelmts;
+	uint64_t iblock_nsblks;   //< number of super blocks whose data blocks are in the index block
+	uint64_t iblock_ndblk_addrs;
+	uint64_t dblk_min_nelmts;
+	uint64_t dblk_page_nelmts;
+	uint64_t max_index_set;
+	vector<super_block_info_t> sblk_info;
+
+	extensible_array(file_handler_t * file, uint8_t * addr) :
+		file{file}, memory_addr{addr}, iblock{nullptr}
+	{
+		if (std::memcmp(spec::signature::get(memory_addr), "EAHD", 4) != 0)
+			throw EXCEPTION("Invalid extensible array header signature");
+
+		element_size = spec::element_size::get(memory_addr);
+		uint64_t max_nelmts_bits = spec::max_nelmts_bits::get(memory_addr);
+		arr_off_size = (max_nelmts_bits+7)/8;
+		iblock_nelmts = spec::index_block_elements::get(memory_addr);
+		dblk_min_nelmts = spec::data_block_min_elements::get(memory_addr);
+		dblk_page_nelmts = 1ul << spec::max_dblk_page_nelmts_bits::get(memory_addr);
+		max_index_set = spec::max_index_set::get(memory_addr);
+
+		uint64_t sblk_min_data_ptrs = spec::secondary_block_min_data_ptrs::get(memory_addr);
+		if (dblk_min_nelmts == 0 or sblk_min_data_ptrs == 0)
+			throw EXCEPTION("Invalid extensible array parameters");
+		iblock_nsblks = 2*log2_floor(sblk_min_data_ptrs);
+		iblock_ndblk_addrs = 2*(sblk_min_data_ptrs-1);
+
+		// super block k hold 2^(k/2) data blocks of 2^((k+1)/2)*dblk_min_nelmts elements.
+		uint64_t nsblks = 1 + max_nelmts_bits - log2_floor(dblk_min_nelmts);
+		uint64_t start_idx = 0;
+		uint64_t start_dblk = 0;
+		for (uint64_t k = 0; k < nsblks; ++k) {
+			super_block_info_t info;
+			info.ndblks = 1ul << (k/2);
+			info.dblk_nelmts = (1ul << ((k+1)/2))*dblk_min_nelmts;
+			info.start_idx = start_idx;
+			info.start_dblk = start_dblk;
+			sblk_info.push_back(info);
+			start_idx += info.ndblks*info.dblk_nelmts;
+			start_dblk += info.ndblks;
+		}
+
+		uint64_t iblock_address = spec::index_block_address::get(memory_addr);
+		if (iblock_address == static_cast<uint64_t>(undef_offset))
+			return;
+
+		iblock = file->to_address(iblock_address);
+		if (std::memcmp(block_spec::signature::get(iblock), "EAIB", 4) != 0)
+			throw EXCEPTION("Invalid extensible array index block signature");
+	}
+
+	bool client_is_filtered_chunk() const
+	{
+		return spec::client_id::get(memory_addr) == 1;
+	}
+
+	// page_init is the page bitmap of the super block, nullptr if pages are always initialized.
+	uint8_t * _dblock_element(uint64_t dblock_address, uint64_t dblk_nelmts, uint64_t elmt_idx, uint8_t const * page_init, uint64_t page_init_idx) const
+	{
+		uint8_t * dblock = file->to_address(dblock_address);
+		if (std::memcmp(block_spec::signature::get(dblock), "EADB", 4) != 0)
+			throw EXCEPTION("Invalid extensible array data block signature");
+
+		uint8_t * data = dblock + block_spec::size + arr_off_size;
+		if (dblk_nelmts <= dblk_page_nelmts)
+			return data + elmt_idx*element_size;
+
+		// pages come after the data block checksum.
+		uint64_t page_idx = elmt_idx/dblk_page_nelmts;
+		page_init_idx += page_idx;
+		if (page_init and not (page_init[page_init_idx/8] & (0x80u >> (page_init_idx%8))))
+			return nullptr;
+		return data + 4 + page_idx*(dblk_page_nelmts*element_size+4) + (elmt_idx%dblk_page_nelmts)*element_size;
+	}
+
+	// return the element idx, nullptr if it was never set.
+	uint8_t * get_element(uint64_t idx) const
+	{
+		if (not iblock or idx >= max_index_set)
+			return nullptr;
+
+		uint8_t * elements = iblock + block_spec::size;
+		if (idx < iblock_nelmts)
+			return elements + idx*element_size;
+
+		uint8_t * dblk_addrs = elements + iblock_nelmts*element_size;
+		uint8_t * sblk_addrs = dblk_addrs + iblock_ndblk_addrs*SIZE_OF_OFFSET;
+
+		idx -= iblock_nelmts;
+		uint64_t sblk_idx = log2_floor(idx/dblk_min_nelmts + 1);
+		if (sblk_idx >= sblk_info.size())
+			return nullptr;
+
+		auto const & info = sblk_info[sblk_idx];
+		uint64_t dblk_idx = (idx - info.start_idx)/info.dblk_nelmts;
+		uint64_t elmt_idx = (idx - info.start_idx)%info.dblk_nelmts;
+
+		// data blocks of the first super blocks are directly referenced by the index block.
+		if (sblk_idx < iblock_nsblks) {
+			offset_type dblock_address = read_at<offset_type>(dblk_addrs + (info.start_dblk+dblk_idx)*SIZE_OF_OFFSET);
+			if (dblock_address == undef_offset)
+				return nullptr;
+			return _dblock_element(dblock_address, info.dblk_nelmts, elmt_idx, nullptr, 0);
+		}
+
+		offset_type sblock_address = read_at<offset_type>(sblk_addrs + (sblk_idx-iblock_nsblks)*SIZE_OF_OFFSET);
+		if (sblock_address == undef_offset)
+			return nullptr;
+
+		uint8_t * sblock = file->to_address(sblock_address);
+		if (std::memcmp(block_spec::signature::get(sblock), "EASB", 4) != 0)
+			throw EXCEPTION("Invalid extensible array secondary block signature");
+
+		uint8_t * page_init = sblock + block_spec::size + arr_off_size;
+		uint8_t * addrs = page_init;
+		uint64_t npages = 0;
+		if (info.dblk_nelmts > dblk_page_nelmts) {
+			npages = info.dblk_nelmts/dblk_page_nelmts;
+			addrs += info.ndblks*((npages+7)/8);
+		}
+
+		offset_type dblock_address = read_at<offset_type>(addrs + dblk_idx*SIZE_OF_OFFSET);
+		if (dblock_address == undef_offset)
+			return nullptr;
+		return _dblock_element(dblock_address, info.dblk_nelmts, elmt_idx, npages?page_init:nullptr, dblk_idx*npages);
+	}
+
+};
+
+// Version 2 B-tree walker, records are returned as raw pointers, their layout
+// depend on the tree type.
+struct btree_v2_records {
+	using spec = typename spec_defs::b_tree_v2_hdr_spec;
+	using node_spec = typename spec_defs::b_tree_v2_node_spec;
+
+	struct node_info_t {
+		uint64_t max_nrec;
+		uint64_t cum_max_nrec;
+		uint64_t cum_max_nrec_size;
+	};
+
+	file_handler_t * file;
+	uint8_t * memory_addr;
+	uint64_t record_size;
+	uint64_t max_nrec_size;   //< size of the number of records field in child pointers
+	vector<node_info_t> node_info;
+
+	// number of bytes needed to store n.
+	static uint64_t limit_enc_size(uint64_t n)
+	{
+		return log2_floor(n)/8+1;
+	}
+
+	btree_v2_records(file_handler_t * file, uint8_t * addr) : file{file}, memory_addr{addr}
+	{
+		if (std::memcmp(spec::signature::get(memory_addr), "BTHD", 4) != 0)
+			throw EXCEPTION("Invalid B-tree v2 header signature");
+
+		uint64_t node_size = spec::node_size::get(memory_addr);
+		uint64_t depth = spec::depth::get(memory_addr);
+		record_size = spec::record_size::get(memory_addr);
+
+		// node prefix is signature, version, type and checksum.
+		uint64_t const prefix = node_spec::size + 4;
+		node_info.resize(depth+1);
+		node_info[0].max_nrec = (node_size-prefix)/record_size;
+		node_info[0].cum_max_nrec = node_info[0].max_nrec;
+		node_info[0].cum_max_nrec_size = 0;
+		max_nrec_size = limit_enc_size(node_info[0].max_nrec);
+		for (uint64_t d = 1; d <= depth; ++d) {
+			uint64_t pointer_size = SIZE_OF_OFFSET + max_nrec_size + (d > 1 ? node_info[d-1].cum_max_nrec_size : 0);
+			node_info[d].max_nrec = (node_size-prefix-pointer_size)/(record_size+pointer_size);
+			node_info[d].cum_max_nrec = (node_info[d].max_nrec+1)*node_info[d-1].cum_max_nrec + node_info[d].max_nrec;
+			node_info[d].cum_max_nrec_size = limit_enc_size(node_info[d].cum_max_nrec);
+		}
+	}
+
+	uint8_t type() const
+	{
+		return spec::type::get(memory_addr);
+	}
+
+	template<typename F>
+	void _for_each_record(uint64_t address, uint64_t nrec, uint64_t depth, F & func) const
+	{
+		uint8_t * records = file->to_address(address) + node_spec::size;
+		for (uint64_t i = 0; i < nrec; ++i) {
+			func(records + i*record_size);
+		}
+
+		if (depth == 0)
+			return;
+
+		// internal node, the nrec+1 child pointers follow the records.
+		uint8_t * pointer = records + nrec*record_size;
+		uint64_t pointer_size = SIZE_OF_OFFSET + max_nrec_size + (depth > 1 ? node_info[depth-1].cum_max_nrec_size : 0);
+		for (uint64_t i = 0; i <= nrec; ++i) {
+			uint64_t child_address = read_at<offset_type>(pointer);
+			uint64_t child_nrec = read_uint(pointer+SIZE_OF_OFFSET, max_nrec_size);
+			_for_each_record(child_address, child_nrec, depth-1, func);
+			pointer += pointer_size;
+		}
+	}
+
+	// call func(record) for each record of the tree.
+	template<typename F>
+	void for_each_record(F && func) const
+	{
+		uint64_t root = spec::root_node_address::get(memory_addr);
+		if (root == static_cast<uint64_t>(undef_offset))
+			return;
+		_for_each_record(root, spec::number_of_records_in_root_node::get(memory_addr), spec::depth::get(memory_addr), func);
+	}
+
+	template<typename C, typename F>
+	bool _find_records(uint64_t address, uint64_t nrec, uint64_t depth, C & cmp, F & func) const
+	{
+		uint8_t * records = file->to_address(address) + node_spec::size;
+
+		// first record that is not before the key.
+		uint64_t lo = 0;
+		uint64_t hi = nrec;
+		while (lo < hi) {
+			uint64_t mi = (lo + hi)/2;
+			if (cmp(records + mi*record_size) < 0) {
+				lo = mi+1;
+			} else {
+				hi = mi;
+			}
+		}
+
+		uint8_t * pointer = records + nrec*record_size;
+		uint64_t pointer_size = SIZE_OF_OFFSET + max_nrec_size + (depth > 1 ? node_info[depth-1].cum_max_nrec_size : 0);
+		for (uint64_t i = lo; ; ++i) {
+			// child i hold the records between record i-1 and record i.
+			if (depth > 0) {
+				uint8_t * p = pointer + i*pointer_size;
+				if (_find_records(read_at<offset_type>(p), read_uint(p+SIZE_OF_OFFSET, max_nrec_size), depth-1, cmp, func))
+					return true;
+			}
+
+			if (i >= nrec or cmp(records + i*record_size) > 0)
+				return false;
+
+			if (func(records + i*record_size))
+				return true;
+		}
+	}
+
+	/**
+	 * call func(record) for each record that match the key, in order, until
+	 * func return true. cmp(record) return <0, 0 or >0 if the record is
+	 * before, equal or after the key. Many records can share the same key,
+	 * e.g. names with colliding hashes.
+	 * @return true if func stopped the search.
+	 **/
+	template<typename C, typename F>
+	bool find_records(C && cmp, F && func) const
+	{
+		uint64_t root = spec::root_node_address::get(memory_addr);
+		if (root == static_cast<uint64_t>(undef_offset))
+			return false;
+		return _find_records(root, spec::number_of_records_in_root_node::get(memory_addr), spec::depth::get(memory_addr), cmp, func);
+	}
+
+};
+
+struct object_datalayout_t : public h5ng::object_datalayout_t {
+	file_handler_t * file;
+
+	// Create the layout from already decoded message.
+	object_datalayout_t(file_handler_t * file, h5ng::object_datalayout_t const & x) :
+		h5ng::object_datalayout_t{x}, file{file}
+	{
+
+	}
+
+	object_datalayout_t(file_handler_t * file, uint8_t * msg) : file{file}
+	{
+	//		cout << "parse_datalayout " << std::dec <<
+	//				" version=" << static_cast<unsigned>(spec_defs::message_data_layout_v1_spec::version::get(msg)) <<
+	//				endl;
+
+		version = spec_defs::message_data_layout_v1_spec::version::get(msg);
 
 		switch(version) {
 		case 1:
@@ -1846,6 +2802,7 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 				break;
 			}
 			case LAYOUT_CHUNKED: {
+				chunk_flags = 0;
 				chunk_indexing_type = CHUNK_INDEXING_BTREE_V1;
 				chunk_dimensionality = spec_defs::message_data_layout_v1_spec::dimensionnality::get(msg);
 				chunk_btree_v1.data_address = cur.read<offset_type>();
@@ -1878,6 +2835,7 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 				contiguous_data_size = cur.read<length_type>();
 				break;
 			case LAYOUT_CHUNKED: {
+				chunk_flags = 0;
 				chunk_indexing_type = CHUNK_INDEXING_BTREE_V1;
 				chunk_dimensionality = cur.read<uint8_t>();
 				chunk_btree_v1.data_address = cur.read<offset_type>();
@@ -1895,7 +2853,8 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 			break;
 		}
 
-		case 4: {
+		case 4:
+		case 5: { // version 5, written by libhdf5 2.0, use the version 4 encoding.
 			layout_class = spec_defs::message_data_layout_v4_spec::layout_class::get(msg);
 
 			auto cur = addr_reader{msg+spec_defs::message_data_layout_v4_spec::size};
@@ -1920,13 +2879,21 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 				for (unsigned i = 0; i < chunk_dimensionality; ++i)
 					chunk_shape[i] = cur.read_int(dimensionality_encoded_size);
 
+				// the last dimension is the element size, as in previous versions.
+				chunk_size_of_element = chunk_shape.back();
+
 				chunk_indexing_type = cur.read<uint8_t>();
 
-				uint64_t size_of_index_data = 0;
 				switch(chunk_indexing_type) {
 				case CHUNK_INDEXING_SINGLE_CHUNK:
-					chunk_single_chunk.size_of_filtered_chunk = cur.read<length_type>();
-					chunk_single_chunk.filters = cur.read<uint32_t>();
+					// size and filters are only stored for filtered chunk.
+					if (chunk_flags & CHUNK_FLAG_SINGLE_INDEX_WITH_FILTER) {
+						chunk_single_chunk.size_of_filtered_chunk = cur.read<length_type>();
+						chunk_single_chunk.filters = cur.read<uint32_t>();
+					} else {
+						chunk_single_chunk.size_of_filtered_chunk = undef_length;
+						chunk_single_chunk.filters = 0;
+					}
 					chunk_single_chunk.data_address = cur.read<offset_type>();
 					break;
 				case CHUNK_INDEXING_IMPLICIT:
@@ -1941,7 +2908,7 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 					chunk_extensible_array.index_elements = cur.read<uint8_t>();
 					chunk_extensible_array.min_pointers = cur.read<uint8_t>();
 					chunk_extensible_array.min_elements = cur.read<uint8_t>();
-					chunk_extensible_array.page_bits = cur.read<uint16_t>();
+					chunk_extensible_array.page_bits = cur.read<uint8_t>();
 					chunk_extensible_array.data_address = cur.read<offset_type>();
 					break;
 				case CHUNK_INDEXING_BTREE_V2:
@@ -1950,16 +2917,20 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 					chunk_btree_v2.merge_percent = cur.read<uint8_t>();
 					chunk_btree_v2.data_address = cur.read<offset_type>();
 					break;
+				default:
+					throw EXCEPTION("Unexpected chunk indexing type (%d)", chunk_indexing_type);
 				}
 
 				break;
 			}
 			case LAYOUT_VIRTUAL:
-				throw EXCEPTION("Unimplemented virtual dataset");
+				// the mapping is not decoded, reading such dataset is not implemented.
+				break;
 			default:
 				throw EXCEPTION("Unexpected layout_class");
-		}
+			}
 
+			break;
 		}
 		default:
 			throw EXCEPTION("Unexpected layout_class");
@@ -1968,109 +2939,125 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 	}
 
 
-	// A is the key entry in btree_v1
-	// B is the key that we looking for
-	inline int chunk_btree_v1_key_cmp(uint8_t const * a, uint8_t const * b)
+	// size in bytes of an unfiltered chunk.
+	uint64_t chunk_size_in_bytes() const
 	{
-		auto ak = reinterpret_cast<uint64_t const *>(a+spec_defs::b_tree_v1_chunk_key_spec::size);
-		auto bk =  reinterpret_cast<uint64_t const *>(b);
+		uint64_t ret = 1;
+		for (auto x: chunk_shape) ret *= x; // the last dimension is the element size
+		return ret;
+	}
 
-		for (int i = 0; i < chunk_dimensionality; ++i) {
-			if (ak[i] == bk[i]) continue;
-			return (ak[i]<bk[i])?-1:1;
+	bool chunk_is_partial_edge(h5ng::object_dataspace_t const & dataspace, uint64_t const * scaled) const
+	{
+		for (unsigned i = 0; i < dataspace.rank; ++i) {
+			if ((scaled[i]+1)*chunk_shape[i] > dataspace.shape[i])
+				return true;
 		}
-
-		return 0;
+		return false;
 	}
 
-	// If the key is not found return -1, chunk may be missing it's not an error.
-	static size_t chunk_btree_v1_find_index(btree_v1 const & cur, uint64_t key_length, uint64_t const * key)
+	// Call func(scaled, idx) for each chunk of the grid, idx is the position
+	// of the chunk in array based indexes: row-major over the maximum
+	// dataspace with the unlimited dimension, if any, moved first.
+	template<typename F>
+	void chunk_array_for_each(h5ng::object_dataspace_t const & dataspace, vector<uint64_t> const & grid, F && func) const
 	{
+		unsigned rank = grid.size();
 
-		size_t lo = 0;
-		size_t hi = cur.get_entries_count();
+		vector<unsigned> order;
+		for (unsigned i = 0; i < rank; ++i) {
+			if (dataspace.max_shape[i] == static_cast<uint64_t>(undef_length))
+				order.push_back(i);
+		}
+
+		if (order.size() > 1)
+			throw EXCEPTION("Array chunk index with more than one unlimited dimension");
 
-		// Key not found
-		if (chunk_btree_v1_key_cmp(cur.get_key(key_length, lo), key) <= 0) {
-			return -1;
+		for (unsigned i = 0; i < rank; ++i) {
+			if (dataspace.max_shape[i] != static_cast<uint64_t>(undef_length))
+				order.push_back(i);
 		}
 
-		// Key not found
-		if (not (chunk_btree_v1_key_cmp(cur.get_key(key_length, hi), key) <= 0)) {
-			return -1;
+		vector<uint64_t> down(rank);
+		uint64_t d = 1;
+		for (unsigned j = rank; j-- > 0;) {
+			down[order[j]] = d;
+			if (j > 0)
+				d *= (dataspace.max_shape[order[j]]+chunk_shape[order[j]]-1)/chunk_shape[order[j]];
 		}
 
-		while (lo - hi > 1) {
-			size_t mi = (lo + hi)/2;
-			if (chunk_btree_v1_key_cmp(cur.get_key(key_length, mi), key) <= 0) {
-				lo = mi;
-			} else {
-				hi = mi;
-			}
+		for (auto x: grid) {
+			if (x == 0)
+				return;
 		}
 
-		return lo;
+		vector<uint64_t> scaled(rank, 0);
+		while (true) {
+			uint64_t idx = 0;
+			for (unsigned i = 0; i < rank; ++i)
+				idx += scaled[i]*down[i];
+			func(&scaled[0], idx);
 
+			int i = rank-1;
+			for (; i >= 0; --i) {
+				if (++scaled[i] < grid[i])
+					break;
+				scaled[i] = 0;
+			}
+			if (i < 0)
+				break;
+		}
 	}
 
-	chunk_desc_t chunk_btree_v1_find(uint64_t const * key) const
+	// decode an element of fixed or extensible array: address, then size and filters if filtered.
+	template<typename F>
+	void chunk_array_element(uint8_t * elmt, uint64_t entry_size, bool filtered, uint64_t const * scaled, F & add) const
 	{
-		uint64_t key_length = spec_defs::b_tree_v1_chunk_key_spec::size+chunk_dimensionality*sizeof(uint64_t);
-
-		// Chunk aren't allocated
-		if (chunk_btree_v1.data_address == undef_offset)
-			return chunk_desc_t{0u,0u,undef_offset};
-
-		btree_v1 cur{file->to_address(chunk_btree_v1.data_address)};
-
-		while(cur.get_depth() != 0) {
-			size_t i = chunk_btree_v1_find_index(cur, key);
-			cur = btree_v1{file->to_address(cur.get_node(key_length, i))};
-		}
-
-		size_t i = chunk_btree_v1_find_index(cur, key);
-		if (i < 0) {
-			return chunk_desc_t{0u,0u,undef_offset};
-		}
-
-		// if the key of the current node does not match the key, the chunk is not found.
-		if (chunk_btree_v1_key_cmp(cur.get_key(key_length, i), i) != 0) {
-			return chunk_desc_t{0u,0u,undef_offset};
+		if (not elmt)
+			return;
+		offset_type address = read_at<offset_type>(elmt);
+		if (address == undef_offset)
+			return;
+		if (filtered) {
+			uint64_t size_length = entry_size-SIZE_OF_OFFSET-4;
+			uint64_t size = read_uint(elmt+SIZE_OF_OFFSET, size_length);
+			uint32_t filters = read_at<uint32_t>(elmt+SIZE_OF_OFFSET+size_length);
+			add(scaled, size, filters, address);
+		} else {
+			add(scaled, chunk_size_in_bytes(), 0u, address);
 		}
-
-		return chunk_desc_t{
-			spec_defs::b_tree_v1_chunk_key_spec::chunk_size::get(cur.get_key(key_length, i)),
-			spec_defs::b_tree_v1_chunk_key_spec::filter_mask::get(cur.get_key(key_length, i)),
-			static_cast<uint64_t>(cur.get_node(key_length, i))
-		};
-
 	}
 
-	void chunk_btree_v1_ls(vector<chunk_desc_t> & ret) const
+	template<typename F>
+	void chunk_btree_v1_index(F & add) const
 	{
 		uint64_t const key_length = spec_defs::b_tree_v1_chunk_key_spec::size+chunk_dimensionality*sizeof(uint64_t);
 
-		stack<btree_v1> stack;
-
 		// Chunk aren't allocated
-		if (chunk_btree_v1.data_address == undef_max_offset)
+		if (chunk_btree_v1.data_address == static_cast<uint64_t>(undef_offset))
 			return;
 
+		vector<uint64_t> scaled(chunk_dimensionality-1);
+
+		stack<btree_v1> stack;
 		stack.push(btree_v1{file->to_address(chunk_btree_v1.data_address)});
 		while(not stack.empty()) {
 			btree_v1 cur = stack.top();
 			stack.pop();
 
 			if (cur.get_depth() == 0) {
-				//assert(cur.get_entries_count() <= lK);
 				for(int i = 0; i < cur.get_entries_count(); ++i) {
-					ret.emplace_back(
-							spec_defs::b_tree_v1_chunk_key_spec::chunk_size::get(cur.get_key(key_length, i)),
-							spec_defs::b_tree_v1_chunk_key_spec::filter_mask::get(cur.get_key(key_length, i)),
-							static_cast<uint64_t>(cur.get_node(key_length, i)));
+					auto key = cur.get_key(key_length, i);
+					// keys store the offset of the first element of the chunk.
+					auto offset = reinterpret_cast<uint64_t const *>(key+spec_defs::b_tree_v1_chunk_key_spec::size);
+					for (unsigned d = 0; d < scaled.size(); ++d)
+						scaled[d] = offset[d]/chunk_shape[d];
+					add(&scaled[0],
+							spec_defs::b_tree_v1_chunk_key_spec::chunk_size::get(key),
+							spec_defs::b_tree_v1_chunk_key_spec::filter_mask::get(key),
+							cur.get_node(key_length, i));
 				}
 			} else {
-				//assert(cur.get_entries_count() <= nK);
 				for(int i = 0; i < cur.get_entries_count(); ++i) {
 					stack.push(btree_v1{file->to_address(cur.get_node(key_length, i))});
 				}
@@ -2078,11 +3065,120 @@ struct object_datalayout_t : public h5ng::object_datalayout_t {
 		}
 	}
 
-	vector<chunk_desc_t> chunk_btree_v1_ls() const
+	template<typename F>
+	void chunk_btree_v2_index(F & add) const
 	{
-		vector<chunk_desc_t> ret;
-		chunk_btree_v1_ls(ret);
-		return ret;
+		if (chunk_btree_v2.data_address == static_cast<uint64_t>(undef_offset))
+			return;
+
+		btree_v2_records btree{file, file->to_address(chunk_btree_v2.data_address)};
+		uint64_t rank = chunk_dimensionality-1;
+		vector<uint64_t> scaled(rank);
+
+		switch (btree.type()) {
+		case 10: // non-filtered: address, scaled offsets
+			btree.for_each_record([&](uint8_t * record) {
+				auto offset = reinterpret_cast<uint64_t const *>(record+SIZE_OF_OFFSET);
+				std::copy(offset, offset+rank, scaled.begin());
+				add(&scaled[0], chunk_size_in_bytes(), 0u, read_at<offset_type>(record));
+			});
+			break;
+		case 11: { // filtered: address, size, filters, scaled offsets
+			uint64_t size_length = btree.record_size-SIZE_OF_OFFSET-4-rank*sizeof(uint64_t);
+			btree.for_each_record([&](uint8_t * record) {
+				auto offset = reinterpret_cast<uint64_t const *>(record+SIZE_OF_OFFSET+size_length+4);
+				std::copy(offset, offset+rank, scaled.begin());
+				add(&scaled[0], read_uint(record+SIZE_OF_OFFSET, size_length), read_at<uint32_t>(record+SIZE_OF_OFFSET+size_length), read_at<offset_type>(record));
+			});
+			break;
+		}
+		default:
+			throw EXCEPTION("Unexpected B-tree v2 type for chunk index (%d)", btree.type());
+		}
+	}
+
+	/**
+	 * Build the flat index of all allocated chunks for the given dataspace.
+	 * Chunks outside of the current dataspace are ignored.
+	 **/
+	auto make_chunk_index(h5ng::object_dataspace_t const & dataspace) const -> shared_ptr<chunk_index>
+	{
+		if (layout_class != LAYOUT_CHUNKED)
+			throw EXCEPTION("Dataset is not chunked");
+
+		unsigned rank = chunk_dimensionality-1;
+		if (dataspace.rank != rank)
+			throw EXCEPTION("Chunk dimensionality does not match the dataspace rank");
+
+		vector<uint64_t> shape{chunk_shape.begin(), chunk_shape.end()-1};
+		vector<uint64_t> grid(rank);
+		for (unsigned i = 0; i < rank; ++i) {
+			if (shape[i] == 0)
+				throw EXCEPTION("Invalid chunk shape");
+			grid[i] = (dataspace.shape[i]+shape[i]-1)/shape[i];
+		}
+
+		auto index = make_shared<chunk_index>(shape, grid);
+
+		auto add = [&](uint64_t const * scaled, uint64_t size, uint32_t filters, uint64_t address) {
+			// partial edge chunks may be stored without filters.
+			if ((chunk_flags & CHUNK_FLAG_DONT_FILTER_PARTIAL_BOUND_CHUNKS) and chunk_is_partial_edge(dataspace, scaled))
+				filters = ~0u;
+			index->insert(scaled, chunk_desc_t{static_cast<uint32_t>(size), filters, address});
+		};
+
+		switch (chunk_indexing_type) {
+		case CHUNK_INDEXING_BTREE_V1:
+			chunk_btree_v1_index(add);
+			break;
+		case CHUNK_INDEXING_SINGLE_CHUNK: {
+			if (chunk_single_chunk.data_address == static_cast<uint64_t>(undef_offset))
+				break;
+			vector<uint64_t> scaled(rank, 0);
+			if (chunk_flags & CHUNK_FLAG_SINGLE_INDEX_WITH_FILTER) {
+				add(&scaled[0], chunk_single_chunk.size_of_filtered_chunk, chunk_single_chunk.filters, chunk_single_chunk.data_address);
+			} else {
+				add(&scaled[0], chunk_size_in_bytes(), 0u, chunk_single_chunk.data_address);
+			}
+			break;
+		}
+		case CHUNK_INDEXING_IMPLICIT: {
+			// chunks are stored contiguously in array order.
+			if (chunk_implicit.data_address == static_cast<uint64_t>(undef_offset))
+				break;
+			uint64_t size = chunk_size_in_bytes();
+			chunk_array_for_each(dataspace, grid, [&](uint64_t const * scaled, uint64_t idx) {
+				add(scaled, size, 0u, chunk_implicit.data_address+idx*size);
+			});
+			break;
+		}
+		case CHUNK_INDEXING_FIXED_ARRAY: {
+			if (chunk_fixed_array.data_address == static_cast<uint64_t>(undef_offset))
+				break;
+			fixed_array array{file, file->to_address(chunk_fixed_array.data_address)};
+			chunk_array_for_each(dataspace, grid, [&](uint64_t const * scaled, uint64_t idx) {
+				chunk_array_element(array.get_element(idx), array.entry_size, array.client_is_filtered_chunk(), scaled, add);
+			});
+			break;
+		}
+		case CHUNK_INDEXING_EXTENSIBLE_ARRAY: {
+			if (chunk_extensible_array.data_address == static_cast<uint64_t>(undef_offset))
+				break;
+			extensible_array array{file, file->to_address(chunk_extensible_array.data_address)};
+			chunk_array_for_each(dataspace, grid, [&](uint64_t const * scaled, uint64_t idx) {
+				chunk_array_element(array.get_element(idx), array.element_size, array.client_is_filtered_chunk(), scaled, add);
+			});
+			break;
+		}
+		case CHUNK_INDEXING_BTREE_V2:
+			chunk_btree_v2_index(add);
+			break;
+		default:
+			throw EXCEPTION("Unsupported chunk indexing type (%d)", chunk_indexing_type);
+		}
+
+		index->finalize();
+		return index;
 	}
 
 };
@@ -2104,6 +3200,44 @@ struct object_datatype_t : public h5ng::object_datatype_t {
 			   |spec_defs::message_datatype_spec::class_bit_fields_2::get(msg) << 16u;
 
 		size_of_elements = spec_defs::message_datatype_spec::size_of_elements::get(msg);
+
+		uint8_t * properties = msg + spec_defs::message_datatype_spec::size;
+		switch (xclass) {
+		case CLASS_FIXED_POINT: {
+			uint16_t bit_offset = read_at<uint16_t>(properties);
+			uint16_t bit_precision = read_at<uint16_t>(properties+2);
+			// padded integers are not handled.
+			number.valid = bit_offset == 0 and bit_precision == 8*size_of_elements;
+			number.big_endian = flags.test(0);
+			number.is_signed = flags.test(3);
+			number.size = size_of_elements;
+			break;
+		}
+		case CLASS_FLOATING_POINT: {
+			uint16_t bit_offset = read_at<uint16_t>(properties);
+			uint16_t bit_precision = read_at<uint16_t>(properties+2);
+			uint8_t exponent_size = properties[5];
+			uint8_t mantissa_size = properties[7];
+			// only IEEE single and double precision in little or big endian.
+			bool ieee = (size_of_elements == 4 and exponent_size == 8 and mantissa_size == 23)
+					 or (size_of_elements == 8 and exponent_size == 11 and mantissa_size == 52);
+			number.valid = ieee and bit_offset == 0 and bit_precision == 8*size_of_elements and not flags.test(6);
+			number.floating = true;
+			number.big_endian = flags.test(0);
+			number.is_signed = true;
+			number.size = size_of_elements;
+			break;
+		}
+		case CLASS_ENUMERATED: {
+			// the base type immediately follow.
+			object_datatype_t base{properties};
+			if (base.xclass == CLASS_FIXED_POINT)
+				number = base.number;
+			break;
+		}
+		default:
+			break;
+		}
 	}
 
 };
@@ -2180,7 +3314,11 @@ struct object_data_storage_filter_pipeline_t : public h5ng::object_data_storage_
 
 			for (int i = 0; i < nfilter; ++i) {
 				auto filter_identifier = cur.read<uint16_t>();
-				auto name_length = cur.read<uint16_t>();
+				// In version 2 the name is only present for non-predefined filters.
+				uint16_t name_length = 0;
+				if (filter_identifier >= 256) {
+					name_length = cur.read<uint16_t>();
+				}
 				auto flags = cur.read<uint16_t>();
 				auto number_client_data_value = cur.read<uint16_t>();
 				auto name = cur.read_string(name_length);
@@ -2201,16 +3339,19 @@ struct object_data_storage_filter_pipeline_t : public h5ng::object_data_storage_
 };
 
 struct object_fill_value_t : h5ng::object_fill_value_t {
+	uint8_t * value_address; //< the fill value within the file
 
 	object_fill_value_t(uint8_t * msg)
 	{
 		auto cur = addr_reader{msg+spec_defs::message_fillvalue_old_spec::size};
+		value_address = cur.cur;
 		value = cur.read_array<uint8_t>(spec_defs::message_fillvalue_old_spec::size_of_fillvalue::get(msg));
 	}
 
 };
 
 struct object_data_storage_fill_value_t : public h5ng::object_data_storage_fill_value_t {
+	uint8_t * value_address = nullptr; //< the fill value within the file, if any
 
 	object_data_storage_fill_value_t(uint8_t * msg)
 	{
@@ -2226,12 +3367,13 @@ struct object_data_storage_fill_value_t : public h5ng::object_data_storage_fill_
 			flags |= (fill_value_write_time&0b0000'0011u)<<2u;
 
 			auto fill_value_defined = cur.read<uint8_t>();
-			flags |= (fill_value_write_time&0b0000'0001u)<<5u;
+			flags |= (fill_value_defined&0b0000'0001u)<<5u;
 
 			if (not flags.test(5))
 				flags.set(4);
 
 			auto fillvalue_size = cur.read<uint32_t>();
+			value_address = cur.cur;
 			value = cur.read_array<uint8_t>(fillvalue_size);
 			break;
 		}
@@ -2243,13 +3385,14 @@ struct object_data_storage_fill_value_t : public h5ng::object_data_storage_fill_
 			flags |= (fill_value_write_time&0b0000'0011u)<<2u;
 
 			auto fill_value_defined = cur.read<uint8_t>();
-			flags |= (fill_value_write_time&0b0000'0001u)<<5u;
+			flags |= (fill_value_defined&0b0000'0001u)<<5u;
 
 			if (not flags.test(5))
 				flags.set(4);
 
 			if (flags.test(5)) {
 				auto fillvalue_size = cur.read<uint32_t>();
+				value_address = cur.cur;
 				value = cur.read_array<uint8_t>(fillvalue_size);
 			}
 
@@ -2260,6 +3403,7 @@ struct object_data_storage_fill_value_t : public h5ng::object_data_storage_fill_
 
 			if (flags.test(5)) {
 				auto fillvalue_size = cur.read<uint32_t>();
+				value_address = cur.cur;
 				value = cur.read_array<uint8_t>(fillvalue_size);
 			}
 			break;
@@ -2304,7 +3448,7 @@ struct object_link_t : public h5ng::object_link_t {
 			charset = cur.read<uint8_t>();
 		}
 
-		uint64_t size_of_length_of_name = 1u<<(flags.to_ulong()&0x0000'0011u);
+		uint64_t size_of_length_of_name = 1u<<(flags.to_ulong()&0b11u);
 		uint64_t length_of_name = cur.read_int(size_of_length_of_name);
 
 		name = cur.read_string(length_of_name);
@@ -2319,7 +3463,8 @@ struct object_link_t : public h5ng::object_link_t {
 //		cout << "length_of_name = " << length_of_name << endl;
 //		cout << "name = " << link_name << endl;
 
-		uint64_t object_addr = undef_offset;
+		// only hard links have an address.
+		offset = undef_max_offset;
 
 		switch (type) {
 		case 0: { // Hard link
@@ -2330,7 +3475,8 @@ struct object_link_t : public h5ng::object_link_t {
 		case 1: { // soft link
 			auto size = cur.read<uint16_t>();
 			soft_link_value = cur.read_string(size);
-			cout << "soft link = " << soft_link_value << endl;
+			if (verbosity() > 0)
+				cout << "soft link = " << soft_link_value << endl;
 			EXCEPTION("Soft link aren't implemented yet");
 			break;
 		}
@@ -2346,6 +3492,214 @@ struct object_link_t : public h5ng::object_link_t {
 
 };
 
+// Fractal heap, only managed and tiny objects of non-filtered heaps are
+// supported, that is what libhdf5 use to store links of dense groups.
+struct fractal_heap {
+	using spec = typename spec_defs::fractal_heap_hdr_spec;
+	using block_spec = typename spec_defs::fractal_heap_block_spec;
+
+	file_handler_t * file;
+	uint8_t * memory_addr;
+	uint64_t heap_id_length;
+	uint64_t table_width;
+	uint64_t starting_block_size;
+	uint64_t block_offset_size;  //< size of the block offset field of blocks
+	uint64_t heap_offset_size;   //< size of the offset field of managed heap IDs
+	uint64_t heap_length_size;   //< size of the length field of managed heap IDs
+	uint64_t first_row_bits;     //< log2 of the size of the first row
+	uint64_t max_direct_rows;    //< rows of indirect blocks that point to direct blocks
+
+	// number of bytes needed to store n.
+	static uint64_t limit_enc_size(uint64_t n)
+	{
+		return log2_floor(n)/8+1;
+	}
+
+	fractal_heap(file_handler_t * file, uint8_t * addr) : file{file}, memory_addr{addr}
+	{
+		if (std::memcmp(spec::signature::get(memory_addr), "FRHP", 4) != 0)
+			throw EXCEPTION("Invalid fractal heap signature");
+		if (spec::version::get(memory_addr) != 0)
+			throw EXCEPTION("Unknown fractal heap version (%d)", spec::version::get(memory_addr));
+		if (spec::io_filters_encoded_length::get(memory_addr) != 0)
+			throw EXCEPTION("Filtered fractal heap are not implemented");
+
+		heap_id_length = spec::heap_id_length::get(memory_addr);
+		table_width = spec::table_width::get(memory_addr);
+		starting_block_size = spec::starting_block_size::get(memory_addr);
+		uint64_t max_direct_block_size = spec::maximum_direct_block_size::get(memory_addr);
+		uint64_t max_heap_size = spec::maximum_heap_size::get(memory_addr);
+		uint64_t max_managed_size = spec::maximum_size_of_managed_objects::get(memory_addr);
+
+		block_offset_size = (max_heap_size+7)/8;
+		heap_offset_size = block_offset_size;
+		heap_length_size = limit_enc_size(std::min(max_direct_block_size, max_managed_size));
+		first_row_bits = log2_floor(starting_block_size) + log2_floor(table_width);
+		max_direct_rows = log2_floor(max_direct_block_size) - log2_floor(starting_block_size) + 2;
+	}
+
+	uint64_t row_block_size(uint64_t row) const
+	{
+		return row == 0 ? starting_block_size : starting_block_size << (row-1);
+	}
+
+	uint64_t row_block_offset(uint64_t row) const
+	{
+		return row == 0 ? 0 : (starting_block_size*table_width) << (row-1);
+	}
+
+	// find the entry of the indirect block that hold the heap offset off, relative to the block.
+	void _lookup(uint64_t off, uint64_t & row, uint64_t & col) const
+	{
+		if (off < starting_block_size*table_width) {
+			row = 0;
+			col = off/starting_block_size;
+		} else {
+			row = log2_floor(off) - first_row_bits + 1;
+			col = (off - row_block_offset(row))/row_block_size(row);
+		}
+	}
+
+	// return the address of the managed object at heap offset off.
+	uint8_t * _managed_object(uint64_t off) const
+	{
+		uint64_t block_address = spec::root_block_address::get(memory_addr);
+		uint64_t nrows = spec::current_number_of_rows::get(memory_addr);
+
+		// root indirect block has 0 rows when the root is a direct block.
+		while (nrows > 0) {
+			uint8_t * block = file->to_address(block_address);
+			if (std::memcmp(block_spec::signature::get(block), "FHIB", 4) != 0)
+				throw EXCEPTION("Invalid fractal heap indirect block signature");
+			uint64_t block_offset = read_uint(block + block_spec::size, block_offset_size);
+
+			uint64_t row, col;
+			_lookup(off - block_offset, row, col);
+			if (row >= nrows)
+				throw EXCEPTION("Invalid fractal heap offset");
+
+			block_address = read_at<offset_type>(block + block_spec::size + block_offset_size + (row*table_width+col)*SIZE_OF_OFFSET);
+			if (block_address == static_cast<uint64_t>(undef_offset))
+				throw EXCEPTION("Invalid fractal heap offset");
+
+			if (row < max_direct_rows)
+				break;
+
+			// child indirect block, its rows are sized by its block size.
+			nrows = log2_floor(row_block_size(row)) - first_row_bits + 1;
+		}
+
+		uint8_t * block = file->to_address(block_address);
+		if (std::memcmp(block_spec::signature::get(block), "FHDB", 4) != 0)
+			throw EXCEPTION("Invalid fractal heap direct block signature");
+		uint64_t block_offset = read_uint(block + block_spec::size, block_offset_size);
+		// offsets within direct blocks include the block header.
+		return block + (off - block_offset);
+	}
+
+	/**
+	 * return the address of the object with the heap id, and set its length.
+	 **/
+	uint8_t * get_object(uint8_t * id, uint64_t & length) const
+	{
+		uint8_t flags = id[0];
+		if ((flags >> 6) != 0)
+			throw EXCEPTION("Unknown fractal heap ID version (%d)", flags >> 6);
+
+		switch ((flags >> 4) & 0x3u) {
+		case 0: { // managed
+			uint64_t off = read_uint(id+1, heap_offset_size);
+			length = read_uint(id+1+heap_offset_size, heap_length_size);
+			return _managed_object(off);
+		}
+		case 2: // tiny, the object is stored within the ID
+			if (heap_id_length-1 <= 16) {
+				length = (flags & 0x0fu) + 1;
+				return id+1;
+			} else {
+				length = (((flags & 0x0fu) << 8) | id[1]) + 1;
+				return id+2;
+			}
+		default:
+			throw EXCEPTION("Huge fractal heap objects are not implemented");
+		}
+	}
+
+};
+
+// Links of a group with dense storage, stored in a fractal heap and indexed
+// by name hash within a version 2 B-tree of type 5.
+struct object_dense_links_t : public h5ng::object_link_info_t {
+	file_handler_t * file;
+
+	// Create the dense links from already decoded link info message.
+	object_dense_links_t(file_handler_t * file, h5ng::object_link_info_t const & x) :
+		h5ng::object_link_info_t{x}, file{file}
+	{
+
+	}
+
+	bool empty() const
+	{
+		return fractal_head_address.is_undef() or name_index_b_tree_address.is_undef();
+	}
+
+	// return the object header address of key or undef_offset if not found.
+	max_offset_type find(string const & key) const
+	{
+		if (empty())
+			return undef_offset;
+
+		fractal_heap heap{file, file->to_address(fractal_head_address)};
+		btree_v2_records btree{file, file->to_address(name_index_b_tree_address)};
+		uint32_t hash = jenkins_lookup3(reinterpret_cast<uint8_t const *>(key.data()), key.size());
+
+		max_offset_type ret = undef_offset;
+		btree.find_records([hash](uint8_t * record) -> int {
+			uint32_t h = read_at<uint32_t>(record);
+			return h < hash ? -1 : (h > hash ? 1 : 0);
+		}, [&](uint8_t * record) -> bool {
+			uint64_t length;
+			object_link_t link{heap.get_object(record+4, length)};
+			if (link.name != key)
+				return false; // hash collision
+			ret = link.offset;
+			return true;
+		});
+
+		return ret;
+
+	}
+
+	void ls(vector<string> & ret) const
+	{
+		if (empty())
+			return;
+
+		fractal_heap heap{file, file->to_address(fractal_head_address)};
+		btree_v2_records btree{file, file->to_address(name_index_b_tree_address)};
+		btree.for_each_record([&](uint8_t * record) {
+			uint64_t length;
+			ret.push_back(object_link_t{heap.get_object(record+4, length)}.name);
+		});
+	}
+
+	// same as ls with the address of objects.
+	void list(vector<h5ng::object_link_t> & ret) const
+	{
+		if (empty())
+			return;
+
+		fractal_heap heap{file, file->to_address(fractal_head_address)};
+		btree_v2_records btree{file, file->to_address(name_index_b_tree_address)};
+		btree.for_each_record([&](uint8_t * record) {
+			uint64_t length;
+			ret.push_back(object_link_t{heap.get_object(record+4, length)});
+		});
+	}
+
+};
+
 struct object_group_info_t : public h5ng::object_group_info_t {
 
 	object_group_info_t(uint8_t * msg)
@@ -2435,6 +3789,9 @@ struct object_base : public object
 
 	uint32_t _modification_time;
 
+	// filled by dispatch_message, read-only once the object is loaded.
+	h5ng::object_metadata_t _metadata;
+
 	void parse_object_modifcation_time(uint8_t * msg) {
 //		cout << "parse_object_modifcation_time " << std::dec <<
 //				" version=" << static_cast<unsigned>(spec_defs::message_object_modification_time_spec::version::get(msg)) <<
@@ -2457,26 +3814,40 @@ struct object_base : public object
 		case MSG_NIL:
 			break;
 		case MSG_DATASPACE:
+			_metadata.dataspace = object_dataspace_t{data};
+			_metadata.has_dataspace = true;
 			break;
 		case MSG_LINK_INFO:
+			_metadata.link_info = object_link_info_t{data};
+			_metadata.has_link_info = true;
 			break;
 		case MSG_DATATYPE:
+			_metadata.datatype = object_datatype_t{data};
+			_metadata.has_datatype = true;
 			break;
 		case MSG_FILL_VALUE:
+			_metadata.fillvalue_old = object_fill_value_t{data};
+			_metadata.has_fillvalue_old = true;
 			break;
 		case MSG_DATA_STORAGE_FILL_VALUE:
+			_metadata.fillvalue = object_data_storage_fill_value_t{data};
+			_metadata.has_fillvalue = true;
 			break;
 		case MSG_LINK:
+			_metadata.links.push_back(object_link_t{data});
 			break;
 		case MSG_DATA_STORAGE:
 			break;
 		case MSG_DATA_LAYOUT:
+			_metadata.datalayout = object_datalayout_t{file, data};
+			_metadata.has_datalayout = true;
 			break;
 		case MSG_BOGUS:
 			break;
 		case MSG_GROUP_INFO:
 			break;
 		case MSG_DATA_STORAGE_FILTER_PIPELINE:
+			_metadata.filter_pipeline = object_data_storage_filter_pipeline_t{data};
 			break;
 		case MSG_ATTRIBUTE:
 			// ignore attribute message
@@ -2490,6 +3861,8 @@ struct object_base : public object
 		case MSG_OBJECT_HEADER_CONTINUATION:
 			break;
 		case MSG_SYMBOL_TABLE:
+			_metadata.symbol_table = object_symbol_table_t{file, data};
+			_metadata.has_symbol_table = true;
 			break;
 		case MSG_OBJECT_MODIFICATION_TIME:
 			parse_object_modifcation_time(data);
@@ -2640,8 +4013,10 @@ struct object_v1_trait : public object_base {
 	void parse_messages()
 	{
 		uint64_t msg_count = spec::total_number_of_header_message::get(memory_addr);
-		cout << "parsing "<< msg_count <<" messages" << endl;
-		cout << "object header size = " << spec::header_size::get(memory_addr) << endl;
+		if (verbosity() > 0) {
+			cout << "parsing "<< msg_count <<" messages" << endl;
+			cout << "object header size = " << spec::header_size::get(memory_addr) << endl;
+		}
 
 		for (auto i = get_message_iterator(); not i.end(); ++i) {
 			auto msg = *i;
@@ -2740,10 +4115,11 @@ struct object_v2_trait : public object_base {
 			auto msg = **this;
 
 			if (msg.type == MSG_OBJECT_HEADER_CONTINUATION) {
-				if (spec_defs::message_object_header_continuation_spec::length::get(msg.data) > 0) {
+				// continuation block start with the "OCHK" signature and end with a checksum.
+				if (spec_defs::message_object_header_continuation_spec::length::get(msg.data) > 8) {
 					message_block_queue.emplace_back(
-							file->to_address(spec_defs::message_object_header_continuation_spec::offset::get(msg.data)),
-							spec_defs::message_object_header_continuation_spec::length::get(msg.data)
+							file->to_address(spec_defs::message_object_header_continuation_spec::offset::get(msg.data))+4,
+							spec_defs::message_object_header_continuation_spec::length::get(msg.data)-8
 					);
 				}
 			}
@@ -2751,7 +4127,8 @@ struct object_v2_trait : public object_base {
 			_cur += header_size
 				 +  message_spec::size_of_message::get(_cur);
 
-			if ( _cur >= _end) {
+			// remaining bytes smaller than a message header are a gap.
+			if (_cur + header_size > _end) {
 				message_block_queue.pop_front();
 				if (message_block_queue.empty()) // no more message to read.
 					return *this;
@@ -2772,8 +4149,8 @@ struct object_v2_trait : public object_base {
 	message_iterator_t get_message_iterator() const
 	{
 		uint64_t offset = get_object_header_size();
-		// length - 4 because of checksum.
-		uint64_t length = get_reader_for(get_size_of_size_of_chunk())(&memory_addr[offset-get_size_of_size_of_chunk()]) - 4;
+		// the checksum follow the chunk and is not included in its size.
+		uint64_t length = get_reader_for(get_size_of_size_of_chunk())(&memory_addr[offset-get_size_of_size_of_chunk()]);
 
 		return message_iterator_t{file, spec_defs::message_header_v2_spec::size + (is_attribute_creation_order_tracked()?2:0), &memory_addr[offset], length};
 
@@ -2861,14 +4238,27 @@ struct object_template : public TRAIT, public object_interface {
 	using TRAIT::object::file;
 	using TRAIT::object::memory_addr;
 
+	mutable mutex _chunk_index_lock;
+	mutable shared_ptr<chunk_index const> _chunk_index;
+
+	// entry of the sidecar index, links and chunks are then read from the index.
+	h5ng::index_object_t const * _index_entry;
+
 	using TRAIT::parse_messages;
 	using TRAIT::get_message_iterator;
+	using TRAIT::_metadata;
 
-	object_template(file_handler_t * file, uint8_t * addr) : TRAIT{file, addr}
+	object_template(file_handler_t * file, uint8_t * addr) : TRAIT{file, addr}, _index_entry{nullptr}
 	{
 		parse_messages();
 	}
 
+	// load the object from the sidecar index, the header is not parsed.
+	object_template(file_handler_t * file, uint8_t * addr, h5ng::index_object_t const * entry) : TRAIT{file, addr}, _index_entry{entry}
+	{
+		file->index->decode_metadata(*entry, _metadata);
+	}
+
 	virtual ~object_template() { }
 
 
@@ -2881,132 +4271,246 @@ struct object_template : public TRAIT, public object_interface {
 	// @return the object offset within the file or undef_offset if not found.
 	auto canonical_obj_lookup(string const & name) const -> max_offset_type override
 	{
-		max_offset_type offset = undef_offset;
+		if (_index_entry)
+			return file->index->find_link(*_index_entry, name);
 
-		for (auto i = get_message_iterator(); not i.end() and offset.is_undef(); ++i) {
-			auto msg = *i;
-
-			switch (msg.type) {
-			case MSG_LINK: {
-					auto link = object_link_t{msg.data};
-					if (link.name == name) {
-						offset = link.offset;
-					}
-					break;
-				}
-			case MSG_SYMBOL_TABLE: {
-					try {
-						offset = object_symbol_table_t{file, msg.data}[name];
-					} catch (...) {
+		for (auto const & link: _metadata.links) {
+			if (link.name == name)
+				return link.offset;
+		}
 
-					}
-					break;
-				}
-			}
+		if (_metadata.has_link_info)
+			return object_dense_links_t{file, _metadata.link_info}.find(name);
 
-		}
+		if (_metadata.has_symbol_table)
+			return object_symbol_table_t{file, _metadata.symbol_table}.find(name.c_str());
 
-		return offset;
+		return undef_offset;
 
 	}
 
 
+	/**
+	 * Lookup for sub-object, name can be a path like `a/b/c', a path that
+	 * start with `/' is looked up from the root group.
+	 **/
 	virtual auto operator[](string const & name) const -> h5obj override
 	{
+		if (not name.empty() and name[0] == '/') {
+			auto root = file->get_superblock()->get_root_object();
+			size_t p = name.find_first_not_of('/');
+			if (p == string::npos)
+				return h5obj{root};
+			return root->operator[](name.substr(p));
+		}
 
-		auto offset = this->canonical_obj_lookup(name);
-		if (offset.is_undef())
+		// split the path, empty components are ignored.
+		vector<string> components;
+		vector<size_t> ends; //< end of each prefix within path
+		string path;
+		size_t cpos = 0;
+		while (cpos < name.size()) {
+			size_t npos = name.find('/', cpos);
+			if (npos == string::npos) npos = name.size();
+			if (npos != cpos) {
+				if (not path.empty())
+					path += '/';
+				components.push_back(name.substr(cpos, npos-cpos));
+				path += components.back();
+				ends.push_back(path.size());
+			}
+			cpos = npos+1;
+		}
+
+		if (components.empty())
 			throw EXCEPTION("object named `%s` not found", name.c_str());
-		return h5obj{file->make_object(offset)};
 
-//		auto ret = *this;
-//		size_t cpos = 0;
-//		size_t npos = name.find('/', cpos);
-//		if (npos == string::npos) npos = name.size();
-//
-//		if (cpos != npos) {
-//			offset_type offset = this->canonical_obj_lookup(name.substr(cpos,npos-cpos));
-//			if (offset == undef_offset)
-//				throw EXCEPTION("KeyError: Key not found `%s'", name.c_str());
-//			ret = h5obj{file->make_object(offset)}
-//		}
-//
-//		return h5obj{file->make_object(offset)};
+		uint64_t id = get_id();
+
+		// canonical paths from the root group are in the index.
+		uint64_t address;
+		if (file->index and id == file->index->root() and file->index->find_path(path, address))
+			return h5obj{file->make_object(address)};
+
+		// start from the longest cached prefix.
+		shared_ptr<object_interface> cur;
+		size_t i = components.size();
+		while (i > 1) {
+			cur = file->path_cache.find(make_pair(id, path.substr(0, ends[i-1])));
+			if (cur)
+				break;
+			--i;
+		}
+
+		if (not cur)
+			i = 0;
+
+		for (; i < components.size(); ++i) {
+			auto offset = (cur ? cur->canonical_obj_lookup(components[i]) : this->canonical_obj_lookup(components[i]));
+			if (offset.is_undef())
+				throw EXCEPTION("object named `%s` not found", path.substr(0, ends[i]).c_str());
+			cur = file->make_object(offset);
+			if (i > 0)
+				file->path_cache.get(make_pair(id, path.substr(0, ends[i])), [&cur]() { return cur; });
+		}
+
+		return h5obj{cur};
+
+	}
+
+	virtual auto metadata() const -> h5ng::object_metadata_t const & override
+	{
+		return _metadata;
 	}
 
 	virtual auto shape() const -> vector<size_t> override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_DATASPACE) {
-				auto dataspace = object_dataspace_t{msg.data};
-				return vector<size_t>{&dataspace.shape[0], &dataspace.shape[dataspace.rank]};
-			}
-		}
-		throw EXCEPTION("Shape is not defined");
+		if (not _metadata.has_dataspace)
+			throw EXCEPTION("Shape is not defined");
+		return vector<size_t>{_metadata.dataspace.shape.begin(), _metadata.dataspace.shape.end()};
 	}
 
 
 	virtual auto dataspace() const -> h5ng::object_dataspace_t override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_DATASPACE) {
-				return object_dataspace_t{msg.data};
-			}
-		}
-		throw EXCEPTION("Dataspace Not found!");
+		if (not _metadata.has_dataspace)
+			throw EXCEPTION("Dataspace Not found!");
+		return _metadata.dataspace;
 	}
 
 	virtual auto datalayout() const -> h5ng::object_datalayout_t override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_DATA_LAYOUT) {
-				return object_datalayout_t{file, msg.data};
-			}
-		}
-		throw EXCEPTION("Datalayout Not found!");
+		if (not _metadata.has_datalayout)
+			throw EXCEPTION("Datalayout Not found!");
+		return _metadata.datalayout;
 	}
 
 	virtual auto fillvalue_old() const -> h5ng::object_fill_value_t override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_FILL_VALUE) {
-				return object_fill_value_t{msg.data};
-			}
-		}
-		throw EXCEPTION("Fill Value (Old) Not found!");
+		if (not _metadata.has_fillvalue_old)
+			throw EXCEPTION("Fill Value (Old) Not found!");
+		return _metadata.fillvalue_old;
 	}
 
 	virtual auto fillvalue() const -> h5ng::object_data_storage_fill_value_t override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_DATA_STORAGE_FILL_VALUE) {
-				return object_data_storage_fill_value_t{msg.data};
-			}
-		}
-		throw EXCEPTION("Fill Value Not found!");
+		if (not _metadata.has_fillvalue)
+			throw EXCEPTION("Fill Value Not found!");
+		return _metadata.fillvalue;
 	}
 
 
 	virtual auto filter_pipeline() const -> h5ng::object_data_storage_filter_pipeline_t override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_DATA_STORAGE_FILTER_PIPELINE) {
-				return object_data_storage_filter_pipeline_t{msg.data};
+		// empty for dataset without filter.
+		return _metadata.filter_pipeline;
+	}
+
+	virtual auto element_size() const -> uint64_t override
+	{
+		if (not _metadata.has_datatype)
+			throw EXCEPTION("Datatype Not found!");
+		return _metadata.datatype.size_of_elements;
+	}
+
+	virtual uint8_t data_layout() const override
+	{
+		if (not _metadata.has_datalayout)
+			throw EXCEPTION("Datalayout Not found!");
+		return _metadata.datalayout.layout_class;
+	}
+
+	// return the address of continuous or compact data, nullptr if the data is not allocated.
+	virtual uint8_t * continuous_data() const override
+	{
+		auto const & layout = _metadata.datalayout;
+		switch (data_layout()) {
+		case object_datalayout_t::LAYOUT_COMPACT:
+			return file->to_address(layout.compact_data_address);
+		case object_datalayout_t::LAYOUT_CONTIGUOUS:
+			if (layout.contiguous_data_address == static_cast<uint64_t>(undef_offset))
+				return nullptr;
+			return file->to_address(layout.contiguous_data_address);
+		default:
+			throw EXCEPTION("Dataset is not continuous");
+		}
+	}
+
+	// return the address of the fill value, nullptr if the fill value is not defined.
+	virtual uint8_t const * fill_value() const override
+	{
+		return _metadata.fill_value();
+	}
+
+	virtual vector<size_t> shape_of_chunk() const override
+	{
+		auto const & layout = _metadata.datalayout;
+		if (data_layout() != object_datalayout_t::LAYOUT_CHUNKED)
+			throw EXCEPTION("Dataset is not chunked");
+		// the last dimension is the element size.
+		return vector<size_t>{layout.chunk_shape.begin(), layout.chunk_shape.end()-1};
+	}
+
+	// return the flat chunk index, it is built on first call.
+	virtual auto get_chunk_index() const -> shared_ptr<chunk_index const> override
+	{
+		unique_lock<mutex> l{_chunk_index_lock};
+		if (_chunk_index)
+			return _chunk_index;
+
+		if (not _metadata.has_datalayout or not _metadata.has_dataspace)
+			throw EXCEPTION("Dataset is not chunked");
+
+		if (_index_entry and (_index_entry->flags & h5ng::index_object_t::HAS_CHUNKS)) {
+			auto const & layout = _metadata.datalayout;
+			if (layout.layout_class != object_datalayout_t::LAYOUT_CHUNKED or layout.chunk_dimensionality != _metadata.dataspace.rank+1)
+				throw EXCEPTION("Dataset is not chunked");
+			vector<uint64_t> shape{layout.chunk_shape.begin(), layout.chunk_shape.end()-1};
+			vector<uint64_t> grid(shape.size());
+			for (size_t i = 0; i < shape.size(); ++i) {
+				if (shape[i] == 0)
+					throw EXCEPTION("Invalid chunk shape");
+				grid[i] = (_metadata.dataspace.shape[i]+shape[i]-1)/shape[i];
 			}
+			_chunk_index = make_shared<chunk_index>(shape, grid, file->index->chunks(*_index_entry), _index_entry->chunk_count, file->index);
+			return _chunk_index;
 		}
-		throw EXCEPTION("Filter pipeline Not found!");
+
+		_chunk_index = object_datalayout_t{file, _metadata.datalayout}.make_chunk_index(_metadata.dataspace);
+		return _chunk_index;
+	}
+
+	virtual uint8_t * chunk_address(chunk_desc_t const & chunk) const override
+	{
+		return file->to_address(chunk.address);
+	}
+
+	virtual auto decoded_chunk_cache() const -> chunk_cache & override
+	{
+		return file->decoded_chunk_cache;
+	}
+
+	virtual auto storage() const -> file_storage & override
+	{
+		return *file->storage;
+	}
+
+	virtual void set_chunk_cache_size(uint64_t bytes) override
+	{
+		file->decoded_chunk_cache.set_budget(bytes);
+	}
+
+	virtual auto chunk_cache_stats() const -> chunk_cache_stats_t override
+	{
+		return file->decoded_chunk_cache.stats();
 	}
 
 
 	virtual size_t shape(int i) const override
 	{
-		return shape()[i];
+		if (not _metadata.has_dataspace)
+			throw EXCEPTION("Shape is not defined");
+		return _metadata.dataspace.shape[i];
 	}
 
 
@@ -3016,27 +4520,40 @@ struct object_template : public TRAIT, public object_interface {
 
 		vector<string> ret;
 
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
+		if (_index_entry) {
+			file->index->keys(*_index_entry, ret);
+			return ret;
+		}
 
-			switch (msg.type) {
-			case MSG_LINK: {
-					auto link = object_link_t{msg.data};
-					ret.push_back(link.name);
-					break;
-				}
-			case MSG_SYMBOL_TABLE: {
-					object_symbol_table_t{file, msg.data}.ls(ret);
-					break;
-				}
-			}
+		for (auto const & link: _metadata.links)
+			ret.push_back(link.name);
 
-		}
+		if (_metadata.has_link_info)
+			object_dense_links_t{file, _metadata.link_info}.ls(ret);
+
+		if (_metadata.has_symbol_table)
+			object_symbol_table_t{file, _metadata.symbol_table}.ls(ret);
 
 		return ret;
 
 	}
 
+	virtual void list_links(vector<h5ng::object_link_t> & ret) const override
+	{
+		if (_index_entry) {
+			file->index->list_links(*_index_entry, ret);
+			return;
+		}
+
+		ret.insert(ret.end(), _metadata.links.begin(), _metadata.links.end());
+
+		if (_metadata.has_link_info)
+			object_dense_links_t{file, _metadata.link_info}.list(ret);
+
+		if (_metadata.has_symbol_table)
+			object_symbol_table_t{file, _metadata.symbol_table}.list(ret);
+	}
+
 	virtual auto list_attributes() const -> vector<string> override
 	{
 		vector<string> ret;
@@ -3121,26 +4638,7 @@ struct object_template : public TRAIT, public object_interface {
 
 	virtual vector<chunk_desc_t> list_chunk() const override
 	{
-		for (auto i = get_message_iterator(); not i.end(); ++i) {
-			auto msg = *i;
-			if (msg.type == MSG_DATA_LAYOUT) {
-				auto datalayout = object_datalayout_t{file, msg.data};
-				switch (datalayout.layout_class) {
-				case object_datalayout_t::LAYOUT_CHUNKED:
-					switch(datalayout.chunk_indexing_type) {
-					case object_datalayout_t::CHUNK_INDEXING_BTREE_V1:
-						return datalayout.chunk_btree_v1_ls();
-					default:
-						throw EXCEPTION("Unsupported chunk layout");
-					}
-					break;
-				default:
-					throw EXCEPTION("Dataset is not chunked");
-				}
-			}
-		}
-
-		throw EXCEPTION("Dataset is not chunked");
+		return get_chunk_index()->list();
 	}
 
 };
@@ -3157,50 +4655,51 @@ typename _impl<SIZE_OF_OFFSET, SIZE_OF_LENGTH>::length_type const _impl<SIZE_OF_
 template<int SIZE_OF_OFFSET, int SIZE_OF_LENGTH>
 auto _impl<SIZE_OF_OFFSET, SIZE_OF_LENGTH>::file_handler_t::make_superblock(max_offset_type offset) -> shared_ptr<superblock_interface>
 {
-	auto x = superblock_cache.find(offset);
-	if (x != superblock_cache.end())
-		return x->second;
-
-	switch(version) {
-	case 0:
-		return superblock_cache[offset] = make_shared<superblock_v0>(this, &memaddr[offset]);
-	case 1:
-		return superblock_cache[offset] = make_shared<superblock_v1>(this, &memaddr[offset]);
-	case 2:
-		return superblock_cache[offset] = make_shared<superblock_v2>(this, &memaddr[offset]);
-	case 3:
-		return superblock_cache[offset] = make_shared<superblock_v3>(this, &memaddr[offset]);
-	default:
-		throw EXCEPTION("Unsuported superblock version (%d)", version);
-	}
-
+	return superblock_cache.get(offset, [this, offset]() -> shared_ptr<superblock_interface> {
+		switch(version) {
+		case 0:
+			return make_shared<superblock_v0>(this, &memaddr[offset]);
+		case 1:
+			return make_shared<superblock_v1>(this, &memaddr[offset]);
+		case 2:
+			return make_shared<superblock_v2>(this, &memaddr[offset]);
+		case 3:
+			return make_shared<superblock_v3>(this, &memaddr[offset]);
+		default:
+			throw EXCEPTION("Unsuported superblock version (%d)", version);
+		}
+	});
 
 }
 
 template<int SIZE_OF_OFFSET, int SIZE_OF_LENGTH>
 auto _impl<SIZE_OF_OFFSET, SIZE_OF_LENGTH>::file_handler_t::make_object(max_offset_type offset) -> shared_ptr<object_interface>
 {
-	auto x = object_cache.find(offset);
-	if (x != object_cache.end()) {
-		return x->second;
-	}
-
-	uint8_t version = memaddr[offset+OFFSET_V1_OBJECT_HEADER_VERSION];
-	if (version == 1u) {
-		cout << "Creating object v1 at 0x" << std::setw(8) << std::setfill('0') << std::hex << offset << endl;
-		return (object_cache[offset] = make_shared<object_template<object_v1_trait>>(this, &memaddr[offset]));
-	} else if (version == 'O') {
-		uint32_t sign = *reinterpret_cast<uint32_t*>(&memaddr[offset]);
-		if (sign != 0x5244484ful)
-			throw EXCEPTION("Unexpected signature (0x%08x)", sign);
-		version = memaddr[offset+OFFSET_V2_OBJECT_HEADER_VERSION];
-		if (version != 2)
-			throw EXCEPTION("Unsupported object version (%d)", version);
-		cout << "Creating object v2 at 0x" << std::setw(8) << std::setfill('0') << std::hex << offset << endl;
-		return (object_cache[offset] = make_shared<object_template<object_v2_trait>>(this, &memaddr[offset]));
-	}
+	return object_cache.get(offset, [this, offset]() -> shared_ptr<object_interface> {
+		h5ng::index_object_t const * entry = index ? index->find_object(offset) : nullptr;
+		uint8_t version = memaddr[offset+OFFSET_V1_OBJECT_HEADER_VERSION];
+		if (version == 1u) {
+			if (verbosity() > 0)
+				cout << "Creating object v1 at 0x" << std::setw(8) << std::setfill('0') << std::hex << offset << std::dec << endl;
+			if (entry)
+				return make_shared<object_template<object_v1_trait>>(this, &memaddr[offset], entry);
+			return make_shared<object_template<object_v1_trait>>(this, &memaddr[offset]);
+		} else if (version == 'O') {
+			uint32_t sign = *reinterpret_cast<uint32_t*>(&memaddr[offset]);
+			if (sign != 0x5244484ful)
+				throw EXCEPTION("Unexpected signature (0x%08x)", sign);
+			version = memaddr[offset+OFFSET_V2_OBJECT_HEADER_VERSION];
+			if (version != 2)
+				throw EXCEPTION("Unsupported object version (%d)", version);
+			if (verbosity() > 0)
+				cout << "Creating object v2 at 0x" << std::setw(8) << std::setfill('0') << std::hex << offset << std::dec << endl;
+			if (entry)
+				return make_shared<object_template<object_v2_trait>>(this, &memaddr[offset], entry);
+			return make_shared<object_template<object_v2_trait>>(this, &memaddr[offset]);
+		}
 
-	throw EXCEPTION("Invalid object @(0x%x)", offset);
+		throw EXCEPTION("Invalid object @(0x%x)", offset);
+	});
 
 }
 
@@ -3254,18 +4753,18 @@ struct _for_each1;
 
 template<int J, int I, int ... ARGS>
 struct _for_each1<J, I, ARGS...> {
-	static shared_ptr<file_handler_interface> create(string const & abs_filename, uint8_t * data, int version, max_offset_type superblock_offset, int size_of_length) {
+	static shared_ptr<file_handler_interface> create(string const & abs_filename, shared_ptr<file_storage> const & storage, int version, max_offset_type superblock_offset, int size_of_length) {
 		if (I == size_of_length) {
-			return make_shared<typename _impl<J, I>::file_handler_t>(abs_filename, data, superblock_offset, version);
+			return make_shared<typename _impl<J, I>::file_handler_t>(abs_filename, storage, superblock_offset, version);
 		} else {
-			return _for_each1<J, ARGS...>::create(abs_filename, data, version, superblock_offset, size_of_length);
+			return _for_each1<J, ARGS...>::create(abs_filename, storage, version, superblock_offset, size_of_length);
 		}
 	}
 };
 
 template<int J>
 struct _for_each1<J> {
-	static shared_ptr<file_handler_interface> create(string const & abs_filename, uint8_t * data, int version, max_offset_type superblock_offset, int size_of_length) {
+	static shared_ptr<file_handler_interface> create(string const & abs_filename, shared_ptr<file_storage> const & storage, int version, max_offset_type superblock_offset, int size_of_length) {
 		throw EXCEPTION("Unsupported offset and length size combination (%d)", size_of_length);
 	}
 };
@@ -3275,18 +4774,18 @@ struct _for_each0;
 
 template<int J, int ... ARGS>
 struct _for_each0<J, ARGS...> {
-	static shared_ptr<file_handler_interface> create(string const & abs_filename, uint8_t * data, int version, max_offset_type superblock_offset, int size_of_offset, int size_of_length) {
+	static shared_ptr<file_handler_interface> create(string const & abs_filename, shared_ptr<file_storage> const & storage, int version, max_offset_type superblock_offset, int size_of_offset, int size_of_length) {
 		if (J == size_of_offset) {
-			return _for_each1<J,2,4,8>::create(abs_filename, data, version, superblock_offset, size_of_length);
+			return _for_each1<J,2,4,8>::create(abs_filename, storage, version, superblock_offset, size_of_length);
 		} else {
-			return _for_each0<ARGS...>::create(abs_filename, data, version, superblock_offset, size_of_offset, size_of_length);
+			return _for_each0<ARGS...>::create(abs_filename, storage, version, superblock_offset, size_of_offset, size_of_length);
 		}
 	}
 };
 
 template<>
 struct _for_each0<> {
-	static shared_ptr<file_handler_interface> create(string const & abs_filename, uint8_t * data, int version, max_offset_type superblock_offset, int size_of_offset, int size_of_length) {
+	static shared_ptr<file_handler_interface> create(string const & abs_filename, shared_ptr<file_storage> const & storage, int version, max_offset_type superblock_offset, int size_of_offset, int size_of_length) {
 		throw EXCEPTION("Unsupported offset and length size combination (%d,%d)", size_of_offset, size_of_length);
 	}
 };
@@ -3321,7 +4820,7 @@ struct _h5group : public _h5obj {
 
 struct _h5file : public _h5obj {
 	string filename;
-	int fd;
+	shared_ptr<file_storage> storage;
 	uint8_t * data;
 	uint64_t file_size;
 	shared_ptr<file_handler_interface> _file_impl;
@@ -3350,21 +4849,102 @@ struct _h5file : public _h5obj {
 	}
 
 
-	_h5file(string const & filename)
+	/**
+	 * Traverse the object graph breadth-first, objects of a level are loaded
+	 * in parallel. Objects are visited once whatever the number of links to
+	 * them, objects that cannot be loaded are left out of the index.
+	 **/
+	vector<uint8_t> _build_index() const
 	{
+		metadata_index_builder builder;
+		uint64_t root = _file_impl->get_superblock()->root_node_object_address();
+		unordered_set<uint64_t> visited{root};
+		vector<pair<uint64_t, string>> level{{root, string{}}};
+		auto pool = default_thread_pool();
+
+		while (not level.empty()) {
+			vector<metadata_index_builder::object_t> objects(level.size());
+			vector<char> loaded(level.size(), 0);
+			pool->parallel_for(level.size(), [&](size_t i) {
+				auto & x = objects[i];
+				x.address = level[i].first;
+				x.path = level[i].second;
+				shared_ptr<object_interface> obj;
+				try {
+					obj = _file_impl->make_object(x.address);
+					x.metadata = obj->metadata();
+					obj->list_links(x.links);
+				} catch (h5ng::exception &) {
+					return;
+				}
 
-		fd = open(filename.c_str(), O_RDONLY);
-		if (fd < 0)
-			throw EXCEPTION("Fail to open file `%s'", filename);
-		struct stat st;
-		fstat(fd, &st);
-		data = static_cast<uint8_t*>(mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
-		if (data == MAP_FAILED)
-			throw EXCEPTION("Fail to mmap the file `%s'", filename);
-		file_size = st.st_size;
+				auto const & meta = x.metadata;
+				if (meta.has_datalayout and meta.has_dataspace and meta.datalayout.layout_class == object_datalayout_t::LAYOUT_CHUNKED) {
+					// unsupported chunk indexes are built on demand.
+					try {
+						x.chunks = obj->get_chunk_index()->flatten();
+						x.has_chunks = true;
+					} catch (h5ng::exception &) { }
+				}
+				loaded[i] = 1;
+			});
+
+			vector<pair<uint64_t, string>> next;
+			for (size_t i = 0; i < objects.size(); ++i) {
+				if (not loaded[i])
+					continue;
+				auto & x = objects[i];
+				for (auto const & link: x.links) {
+					if (link.offset.is_undef() or not visited.insert(link.offset).second)
+						continue;
+					next.emplace_back(link.offset, x.path.empty() ? link.name : x.path + "/" + link.name);
+				}
+				builder.add(std::move(x));
+			}
+			level = std::move(next);
+		}
+
+		return builder.serialize(root, file_size, storage->mtime());
+	}
+
+	// load the sidecar index, build it if requested and it is missing or out of date.
+	void _open_index(string const & filename, index_mode_e mode)
+	{
+		string sidecar = index_filename(filename);
+		shared_ptr<metadata_index const> index;
+		try {
+			auto x = make_shared<metadata_index>(sidecar);
+			if (x->is_up_to_date(file_size, storage->mtime()))
+				index = x;
+		} catch (h5ng::exception &) {
+			// missing or invalid index
+		}
+
+		if (not index and mode == INDEX_BUILD) {
+			auto x = make_shared<metadata_index>(_build_index());
+			try {
+				x->write(sidecar);
+			} catch (h5ng::exception & e) {
+				// the index is still used by this instance, e.g. read-only directory.
+				if (verbosity() > 0)
+					cout << e.what() << endl;
+			}
+			index = x;
+		}
+
+		_file_impl->set_index(index);
+	}
+
+	_h5file(string const & filename, storage_backend_e backend = STORAGE_MMAP, index_mode_e index = INDEX_NONE)
+	{
+
+		storage = make_storage(filename, backend);
+		data = storage->data();
+		file_size = storage->size();
 
 		uint64_t superblock_offset = lookup_for_superblock();
-		cout << "superblock found @" << superblock_offset << endl;
+		if (verbosity() > 0)
+			cout << "superblock found @" << superblock_offset << endl;
 
 		int version = get<uint8_t>(superblock_offset+OFFSET_VERSION);
 		if(version > 3) {
@@ -3374,9 +4954,11 @@ struct _h5file : public _h5obj {
 		int size_of_offset = get<uint8_t>(superblock_offset+OFFSETX[version].offset_of_size_offset);
 		int size_of_length = get<uint8_t>(superblock_offset+OFFSETX[version].offset_of_size_length);
 
-		cout << "file.version = " << version << endl;
-		cout << "file.size_of_offset = " << size_of_offset << endl;
-		cout << "file.size_of_length = " << size_of_length << endl;
+		if (verbosity() > 0) {
+			cout << "file.version = " << version << endl;
+			cout << "file.size_of_offset = " << size_of_offset << endl;
+			cout << "file.size_of_length = " << size_of_length << endl;
+		}
 
 		string abs_filename = filename;
 
@@ -3388,12 +4970,15 @@ struct _h5file : public _h5obj {
 			free(c_cwd);
 		}
 
-		cout << "abs_filename = `"<<abs_filename<<"'"<<endl;
+		if (verbosity() > 0)
+			cout << "abs_filename = `"<<abs_filename<<"'"<<endl;
 
 		/* folowing HDF5 ref implementation size_of_offset and size_of_length must be
 		 * 2, 4, 8, 16 or 32. our implementation is limited to 2, 4 and 8 bytes, uint64_t
 		 */
-		_file_impl = _for_each0<2,4,8>::create(abs_filename, data, version, superblock_offset, size_of_offset, size_of_length);
+		_file_impl = _for_each0<2,4,8>::create(abs_filename, storage, version, superblock_offset, size_of_offset, size_of_length);
+		if (index != INDEX_NONE)
+			_open_index(filename, index);
 		_root_object = _file_impl->get_superblock()->get_root_object();
 	}
 
@@ -3450,6 +5035,16 @@ struct _h5file : public _h5obj {
 		return _root_object->element_size();
 	}
 
+	virtual void set_chunk_cache_size(uint64_t bytes) override
+	{
+		_file_impl->get_chunk_cache().set_budget(bytes);
+	}
+
+	virtual auto chunk_cache_stats() const -> chunk_cache_stats_t override
+	{
+		return _file_impl->get_chunk_cache().stats();
+	}
+
 };
 
 //template<typename T>
@@ -3474,6 +5069,11 @@ void h5obj::read(ARGS ... args) {
 	dynamic_pointer_cast<object_interface>(_ptr)->_read_0(args...);
 }
 
+template<typename ... ARGS>
+void h5obj::read_parallel(ARGS ... args) {
+	dynamic_pointer_cast<object_interface>(_ptr)->_read_parallel_0(args...);
+}
+
 } // hdf5ng
 
 #endif /* SRC_HDF5_NG_HXX_ */
@@ -96,7 +96,7 @@ and these came close:
  11  8 15 26 3 22 24
 -------------------------------------------------------------------------------
 */
-void lookup3_final(uint32_t & a,uint32_t & b, uint32_t & c)
+static inline void lookup3_final(uint32_t & a,uint32_t & b, uint32_t & c)
 {
   c ^= b; c -= lookup3_rot<14>(b);
   a ^= c; a -= lookup3_rot<11>(c);
@@ -113,7 +113,7 @@ void lookup3_final(uint32_t & a,uint32_t & b, uint32_t & c)
  * code any way you wish, private, educational, or commercial.  It's free.
  * Source : HDF5 library
  */
-uint32_t jenkins_lookup3(uint8_t const * data, uint64_t length, uint32_t initval = 0) noexcept
+static inline uint32_t jenkins_lookup3(uint8_t const * data, uint64_t length, uint32_t initval = 0) noexcept
 {
     uint32_t a, b, c;           /* internal state */
 
@@ -143,17 +143,17 @@ uint32_t jenkins_lookup3(uint8_t const * data, uint64_t length, uint32_t initval
     /*-------------------------------- last block: affect all 32 bits of (c) */
     switch(length)                   /* all the case statements fall through */
     {
-        case 12: c+=static_cast<uint32_t>(data[11])<<24;// @suppress("No break at end of case")
-        case 11: c+=static_cast<uint32_t>(data[10])<<16;// @suppress("No break at end of case")
-        case 10: c+=static_cast<uint32_t>(data[9])<<8;  // @suppress("No break at end of case")
-        case 9 : c+=data[8];                            // @suppress("No break at end of case")
-        case 8 : b+=static_cast<uint32_t>(data[7])<<24; // @suppress("No break at end of case")
-        case 7 : b+=static_cast<uint32_t>(data[6])<<16; // @suppress("No break at end of case")
-        case 6 : b+=static_cast<uint32_t>(data[5])<<8;  // @suppress("No break at end of case")
-        case 5 : b+=data[4];                            // @suppress("No break at end of case")
-        case 4 : a+=static_cast<uint32_t>(data[3])<<24; // @suppress("No break at end of case")
-        case 3 : a+=static_cast<uint32_t>(data[2])<<16; // @suppress("No break at end of case")
-        case 2 : a+=static_cast<uint32_t>(data[1])<<8;  // @suppress("No break at end of case")
+        case 12: c+=static_cast<uint32_t>(data[11])<<24; /* fall through */
+        case 11: c+=static_cast<uint32_t>(data[10])<<16; /* fall through */
+        case 10: c+=static_cast<uint32_t>(data[9])<<8;  /* fall through */
+        case 9 : c+=data[8];                            /* fall through */
+        case 8 : b+=static_cast<uint32_t>(data[7])<<24; /* fall through */
+        case 7 : b+=static_cast<uint32_t>(data[6])<<16; /* fall through */
+        case 6 : b+=static_cast<uint32_t>(data[5])<<8;  /* fall through */
+        case 5 : b+=data[4];                            /* fall through */
+        case 4 : a+=static_cast<uint32_t>(data[3])<<24; /* fall through */
+        case 3 : a+=static_cast<uint32_t>(data[2])<<16; /* fall through */
+        case 2 : a+=static_cast<uint32_t>(data[1])<<8;  /* fall through */
         case 1 : a+=data[0];
                  break;
         case 0 : return c;
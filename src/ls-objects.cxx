@@ -2,20 +2,31 @@
 #include <hdf5-ng.hxx>
 #include <iostream>
 #include <stack>
-#include <algorithm>
+#include <unordered_set>
+#include <cstring>
 
 using namespace std;
 
 int main(int argc, char const ** argv) {
-	if (argc < 2)
+	// -i use the sidecar index, build it if it is missing or out of date.
+	h5ng::index_mode_e index = h5ng::INDEX_NONE;
+	int i = 1;
+	if (i < argc and (strcmp(argv[i], "-i") == 0 or strcmp(argv[i], "--index") == 0)) {
+		index = h5ng::INDEX_BUILD;
+		++i;
+	}
+
+	if (argc-i < 1) {
+		cerr << "usage: " << argv[0] << " [-i|--index] <file>" << endl;
 		return 1;
+	}
 
-	h5ng::h5obj hf(argv[1]);
+	h5ng::h5obj hf(argv[i], h5ng::STORAGE_MMAP, index);
 
 	hf.print_info();
 
 	stack<pair<string, h5ng::h5obj>> s;
-	vector<h5ng::h5obj> visited; // avoid recursively print linked object.
+	unordered_set<uint64_t> visited; // id of visited objects, avoid recursively print linked object.
 	s.push(make_pair("", hf));
 	while(not s.empty()) {
 		auto cur = s.top();
@@ -27,8 +38,8 @@ int main(int argc, char const ** argv) {
 			cur.second.print_info();
 			cout << "========== /INFO =========" << endl;
 		} else {
-			if(std::find(visited.begin(), visited.end(), cur.second) == visited.end()) {
-				for(auto x: cur.second.keys()) {
+			if(visited.count(cur.second.get_id()) == 0) {
+				for(auto x: k) {
 					cout << "key :" << x << endl;
 					string name = cur.first + "/" + x;
 					s.push(make_pair(name, cur.second[x]));
@@ -42,7 +53,7 @@ int main(int argc, char const ** argv) {
 			cout << "ATTRIBUTE " << x << endl;
 		}
 
-		visited.push_back(cur.second);
+		visited.insert(cur.second.get_id());
 	}
 
 